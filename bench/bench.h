@@ -0,0 +1,52 @@
+/*
+ * BHLib
+ *
+ * Copyright (c) 2024 Mikhail Romanko
+ */
+#ifndef BHLIB_BENCH_H
+#define BHLIB_BENCH_H
+
+/* Should be included before system headers to request clock_gettime */
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 199309L
+#endif
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+/* Wall clock time in seconds */
+static double bh_bench_now(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER counter, frequency;
+
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+#endif
+}
+
+/* Deterministic xorshift generator, independent from libc rand */
+static uint64_t bh_bench_random(uint64_t *state)
+{
+    uint64_t x;
+
+    x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+#endif /* BHLIB_BENCH_H */
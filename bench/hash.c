@@ -0,0 +1,124 @@
+/*
+ * BHLib
+ *
+ * Copyright (c) 2024 Mikhail Romanko
+ */
+#include "bench.h"
+#include <bh/hash.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Measures hash throughput over several input sizes and avalanche bias:
+ * for every input bit flip, each output bit should flip with probability
+ * of one half.
+ *
+ * Usage: bh_bench_hash [megabytes per size] [avalanche samples]
+ */
+#define BH_BENCH_KEY_MAX 64
+
+static volatile size_t sink;
+
+static void throughput(const unsigned char *data,
+                       size_t total)
+{
+    static const size_t sizes[] = {4, 8, 16, 32, 64, 256, 4096, 65536};
+    size_t i, j, count, size, hash;
+    double start, elapsed;
+
+    for (i = 0; i < sizeof(sizes) / sizeof(*sizes); i++)
+    {
+        size = sizes[i];
+        count = total / size;
+        hash = 0;
+
+        start = bh_bench_now();
+        for (j = 0; j < count; j++)
+            hash ^= bh_hash_bytes(data + (j * size) % (65536 * 4), size, j);
+        elapsed = bh_bench_now() - start;
+        sink = hash;
+
+        printf("bh_hash_bytes %6lu B  %8.3f GB/s  %8.2f ns/hash\n", (unsigned long)size,
+               (double)(count * size) / elapsed * 1e-9,
+               elapsed * 1e9 / (double)count);
+    }
+}
+
+static double avalanche(size_t key,
+                        size_t samples)
+{
+    static size_t flips[BH_BENCH_KEY_MAX * 8][sizeof(size_t) * 8];
+    unsigned char input[BH_BENCH_KEY_MAX];
+    size_t i, j, k, base, diff, bits;
+    uint64_t state;
+    double bias, worst;
+
+    bits = sizeof(size_t) * 8;
+    memset(flips, 0, sizeof(flips));
+    state = 0x2545F4914F6CDD1Dull;
+
+    for (i = 0; i < samples; i++)
+    {
+        for (j = 0; j < key; j++)
+            input[j] = (unsigned char)bh_bench_random(&state);
+
+        base = (key == 8) ? (bh_hash8(input, 0)) : (bh_hash_bytes(input, key, 0));
+        for (j = 0; j < key * 8; j++)
+        {
+            input[j / 8] ^= (unsigned char)(1u << (j % 8));
+            diff = base ^ ((key == 8) ? (bh_hash8(input, 0)) : (bh_hash_bytes(input, key, 0)));
+            input[j / 8] ^= (unsigned char)(1u << (j % 8));
+
+            for (k = 0; k < bits; k++)
+                flips[j][k] += (diff >> k) & 1;
+        }
+    }
+
+    /* Worst deviation from 50% flip probability, scaled to 0..1 */
+    worst = 0.0;
+    for (j = 0; j < key * 8; j++)
+    {
+        for (k = 0; k < bits; k++)
+        {
+            bias = (double)flips[j][k] / (double)samples * 2.0 - 1.0;
+            bias = (bias < 0.0) ? (-bias) : (bias);
+            worst = (bias > worst) ? (bias) : (worst);
+        }
+    }
+
+    return worst;
+}
+
+int main(int argc,
+         char **argv)
+{
+    static const size_t keys[] = {4, 8, 16, 32, 64};
+    unsigned char *data;
+    size_t total, samples, i;
+    uint64_t state;
+
+    total = ((argc > 1) ? (size_t)strtoul(argv[1], NULL, 10) : (256)) << 20;
+    samples = (argc > 2) ? (size_t)strtoul(argv[2], NULL, 10) : (100000);
+
+    data = malloc(65536 * 5);
+    if (!data)
+    {
+        printf("out of memory\n");
+        return EXIT_FAILURE;
+    }
+
+    state = 0x9E3779B97F4A7C15ull;
+    for (i = 0; i < 65536 * 5; i++)
+        data[i] = (unsigned char)bh_bench_random(&state);
+
+    throughput(data, total);
+
+    for (i = 0; i < sizeof(keys) / sizeof(*keys); i++)
+        printf("%-13s %6lu B  worst bias %.4f (%lu samples)\n",
+               (keys[i] == 8) ? ("bh_hash8") : ("bh_hash_bytes"), (unsigned long)keys[i],
+               avalanche(keys[i], samples), (unsigned long)samples);
+
+    free(data);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,111 @@
+/*
+ * BHLib
+ *
+ * Copyright (c) 2024 Mikhail Romanko
+ */
+#include "bench.h"
+#include <bh/algo.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Compares bh_sort against the previous heap sort implementation and libc
+ * qsort on several input patterns.
+ *
+ * Usage: bh_bench_sort [elements]
+ */
+typedef void (*bh_bench_sort_cb_t)(void *, size_t, size_t, bh_compare_cb_t);
+
+static int compare(const void *a,
+                   const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void sort_heap(void *array,
+                      size_t element,
+                      size_t size,
+                      bh_compare_cb_t compare)
+{
+    /* Previous bh_sort implementation */
+    bh_heap_make(array, element, size, compare);
+    while (size)
+        bh_heap_pop(array, element, size--, compare);
+}
+
+static void sort_qsort(void *array,
+                       size_t element,
+                       size_t size,
+                       bh_compare_cb_t compare)
+{
+    qsort(array, size, element, compare);
+}
+
+static void fill(uint32_t *data,
+                 size_t size,
+                 int pattern)
+{
+    uint64_t state;
+    size_t i;
+
+    state = 0x9E3779B97F4A7C15ull;
+    for (i = 0; i < size; i++)
+    {
+        switch (pattern)
+        {
+        case 0: data[i] = (uint32_t)bh_bench_random(&state); break;
+        case 1: data[i] = (uint32_t)i; break;
+        case 2: data[i] = (uint32_t)(size - i); break;
+        default: data[i] = (uint32_t)(bh_bench_random(&state) % 16); break;
+        }
+    }
+}
+
+int main(int argc,
+         char **argv)
+{
+    static const char *patterns[] = {"random", "sorted", "reverse", "few unique"};
+    static const char *names[] = {"bh_sort", "heap sort", "qsort"};
+    bh_bench_sort_cb_t sorts[3];
+    uint32_t *data;
+    size_t size, i, j, k;
+    double start, elapsed;
+
+    size = (argc > 1) ? (size_t)strtoul(argv[1], NULL, 10) : (1000000);
+    sorts[0] = bh_sort;
+    sorts[1] = sort_heap;
+    sorts[2] = sort_qsort;
+
+    data = malloc(size * sizeof(*data));
+    if (!data)
+    {
+        printf("out of memory\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("%lu elements of %lu bytes\n", (unsigned long)size,
+           (unsigned long)sizeof(*data));
+    for (i = 0; i < sizeof(patterns) / sizeof(*patterns); i++)
+    {
+        for (j = 0; j < sizeof(sorts) / sizeof(*sorts); j++)
+        {
+            fill(data, size, (int)i);
+            start = bh_bench_now();
+            sorts[j](data, sizeof(*data), size, compare);
+            elapsed = bh_bench_now() - start;
+
+            for (k = 1; k < size; k++)
+                if (data[k - 1] > data[k])
+                    break;
+
+            printf("%-10s  %-9s  %8.3f s%s\n", patterns[i], names[j], elapsed,
+                   (k < size) ? ("  UNSORTED") : (""));
+        }
+    }
+
+    free(data);
+    return EXIT_SUCCESS;
+}
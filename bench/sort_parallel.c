@@ -0,0 +1,103 @@
+/*
+ * BHLib
+ *
+ * Copyright (c) 2024 Mikhail Romanko
+ */
+#include "bench.h"
+#include <bh/algo.h>
+#include <bh/thread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Sorts the same array of 16-byte records with bh_sort and with
+ * bh_sort_parallel on pools of 1 to N threads.
+ *
+ * Usage: bh_bench_sort_parallel [records] [max threads]
+ */
+typedef struct
+{
+    uint64_t key;
+    uint64_t payload;
+} bh_bench_record_t;
+
+static int compare(const void *a,
+                   const void *b)
+{
+    uint64_t x = ((const bh_bench_record_t *)a)->key;
+    uint64_t y = ((const bh_bench_record_t *)b)->key;
+    return (x > y) - (x < y);
+}
+
+static int check(const bh_bench_record_t *data,
+                 size_t size)
+{
+    size_t i;
+
+    for (i = 1; i < size; i++)
+        if (data[i - 1].key > data[i].key)
+            return -1;
+
+    return 0;
+}
+
+int main(int argc,
+         char **argv)
+{
+    bh_bench_record_t *source, *data;
+    size_t size, threads, i;
+    double start, base, elapsed;
+    uint64_t state;
+    bh_tpool_t pool;
+
+    size = (argc > 1) ? (size_t)strtoul(argv[1], NULL, 10) : (10000000);
+    threads = (argc > 2) ? (size_t)strtoul(argv[2], NULL, 10) : (8);
+
+    source = malloc(size * sizeof(*source));
+    data = malloc(size * sizeof(*data));
+    if (!source || !data)
+    {
+        printf("out of memory\n");
+        return EXIT_FAILURE;
+    }
+
+    state = 0x9E3779B97F4A7C15ull;
+    for (i = 0; i < size; i++)
+    {
+        source[i].key = bh_bench_random(&state);
+        source[i].payload = i;
+    }
+
+    printf("%lu records of %lu bytes\n", (unsigned long)size,
+           (unsigned long)sizeof(bh_bench_record_t));
+
+    memcpy(data, source, size * sizeof(*data));
+    start = bh_bench_now();
+    bh_sort(data, sizeof(*data), size, compare);
+    base = bh_bench_now() - start;
+    printf("bh_sort             %8.3f s\n", base);
+
+    for (i = 1; i <= threads; i++)
+    {
+        if (bh_tpool_init(&pool, i))
+        {
+            printf("can't create pool of %lu threads\n", (unsigned long)i);
+            return EXIT_FAILURE;
+        }
+
+        memcpy(data, source, size * sizeof(*data));
+        start = bh_bench_now();
+        if (bh_sort_parallel(&pool, data, sizeof(*data), size, compare))
+            printf("bh_sort_parallel failed\n");
+        elapsed = bh_bench_now() - start;
+        bh_tpool_destroy(&pool);
+
+        printf("bh_sort_parallel %2lu %8.3f s  speedup %5.2fx%s\n", (unsigned long)i, elapsed,
+               base / elapsed, (check(data, size)) ? ("  UNSORTED") : (""));
+    }
+
+    free(source);
+    free(data);
+    return EXIT_SUCCESS;
+}
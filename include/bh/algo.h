@@ -8,6 +8,24 @@
 #define BHLIB_ALGO_H
 
 #include "bh.h"
+#include <stdio.h>
+
+#define BH_SORT_RADIX_UNSIGNED  0x0000
+#define BH_SORT_RADIX_SIGNED    0x0001
+#define BH_SORT_RADIX_FLOAT     0x0002
+#define BH_SORT_RADIX_BINARY    0x0004
+
+typedef struct bh_merge_run_s bh_merge_run_t;
+typedef int (*bh_merge_refill_cb_t)(bh_merge_run_t *);
+typedef int (*bh_merge_out_cb_t)(const void *, void *);
+
+struct bh_merge_run_s
+{
+    const void *data;
+    size_t size;
+    bh_merge_refill_cb_t refill;
+    void *context;
+};
 
 /**
  * Swap two elements.
@@ -15,24 +33,130 @@
  * @param a     Left element
  * @param b     Right element
  * @param size  Element size
+ *
+ * @sa bh_swap_func
  */
 void bh_swap(void *a,
              void *b,
              size_t size);
 
+/**
+ * Return swap function specialized for the element size.
+ *
+ * Elements of 1, 2, 4, 8 and 16 bytes are swapped with register sized moves,
+ * larger elements are swapped in 32-byte blocks. Callers that swap many
+ * elements of the same size should select the function once.
+ *
+ * @param size  Element size
+ * @return Pointer to the swap function
+ *
+ * @sa bh_swap
+ */
+bh_swap_cb_t bh_swap_func(size_t size);
+
 /**
  * Sort array of elements.
  *
+ * Uses pattern-defeating quicksort: partitioning around median of 3 (or
+ * ninther) pivot, insertion sort for small ranges and heap sort as a fallback
+ * for bad partitions. Already sorted and reverse sorted arrays are handled in
+ * linear time.
+ *
  * @param array    Pointer to the array
  * @param element  Element size
  * @param size     Array size
  * @param compare  Compare function
+ *
+ * @warning Sort is not stable.
  */
 void bh_sort(void *array,
              size_t element,
              size_t size,
              bh_compare_cb_t compare);
 
+/**
+ * Stable sort array of elements.
+ *
+ * Uses adaptive merge sort: natural runs are detected, extended with
+ * insertion sort and merged with galloping. If scratch buffer is not
+ * provided, runs are merged in-place with rotations (slower, but no
+ * additional memory is required).
+ *
+ * @param array    Pointer to the array
+ * @param element  Element size
+ * @param size     Array size
+ * @param compare  Compare function
+ * @param scratch  Pointer to the scratch buffer (at least size / 2 elements)
+ *                 or null
+ *
+ * @sa bh_sort
+ */
+void bh_sort_stable(void *array,
+                    size_t element,
+                    size_t size,
+                    bh_compare_cb_t compare,
+                    void *scratch);
+
+/**
+ * Sort array of elements using thread pool.
+ *
+ * Array is split into chunks, that are sorted in parallel with bh_sort.
+ * Sorted chunks are merged pairwise, where each merge is also split into
+ * independent parts. Jobs are submitted with bh_tpool_job and awaited with
+ * bh_tpool_join (which also waits for unrelated jobs of the pool).
+ *
+ * @param pool     Pointer to the thread pool (or null)
+ * @param array    Pointer to the array
+ * @param element  Element size
+ * @param size     Array size
+ * @param compare  Compare function
+ * @return 0 on success, non-zero otherwise
+ *
+ * @note Jobs that can't be submitted to the pool are run by the calling thread.
+ *
+ * @warning Sort is not stable.
+ *
+ * @sa bh_sort, bh_tpool_job, bh_tpool_join
+ */
+int bh_sort_parallel(bh_tpool_t *pool,
+                     void *array,
+                     size_t element,
+                     size_t size,
+                     bh_compare_cb_t compare);
+
+/**
+ * Sort array of elements by the key with radix sort.
+ *
+ * Key is stored in each element at the specified offset. Keys up to 8 bytes
+ * are sorted with LSD radix sort (one histogram pass for all digits), longer
+ * keys are sorted with MSD radix sort and insertion sort for small buckets.
+ * Digits with the same value in all elements are skipped.
+ *
+ * Key type is determined by flags:
+ * - BH_SORT_RADIX_UNSIGNED - unsigned integer in native byte order
+ * - BH_SORT_RADIX_SIGNED - two's complement integer in native byte order
+ * - BH_SORT_RADIX_FLOAT - IEEE floating point number in native byte order
+ * - BH_SORT_RADIX_BINARY - byte string compared as with memcmp
+ *
+ * @param array       Pointer to the array
+ * @param element     Element size
+ * @param size        Array size
+ * @param key_offset  Key offset within the element
+ * @param key_width   Key size
+ * @param flags       Key flags
+ * @return 0 on success, non-zero otherwise
+ *
+ * @note Sort is stable.
+ *
+ * @sa bh_sort
+ */
+int bh_sort_radix(void *array,
+                  size_t element,
+                  size_t size,
+                  size_t key_offset,
+                  size_t key_width,
+                  int flags);
+
 /**
  * Make heap from the array.
  *
@@ -67,6 +191,28 @@ void bh_heap_pop(void *array,
                  size_t size,
                  bh_compare_cb_t compare);
 
+/**
+ * Replace top element of the heap.
+ *
+ * Equivalent to bh_heap_pop followed by bh_heap_push, but requires only one
+ * sift.
+ *
+ * @param item     Pointer to the item
+ * @param array    Pointer to the array
+ * @param element  Element size
+ * @param size     Array size
+ * @param compare  Compare function
+ *
+ * @warning Replaced element is not destroyed.
+ *
+ * @sa bh_heap_make, bh_heap_pop, bh_heap_push
+ */
+void bh_heap_replace(const void *item,
+                     void *array,
+                     size_t element,
+                     size_t size,
+                     bh_compare_cb_t compare);
+
 /**
  * Insert element into the heap.
  *
@@ -84,4 +230,675 @@ void bh_heap_push(const void *item,
                   size_t size,
                   bh_compare_cb_t compare);
 
+/**
+ * Partially sort array of elements.
+ *
+ * Smallest count elements are placed in sorted order at the beginning of the
+ * array, order of the remaining elements is unspecified. Uses heap select
+ * followed by heap sort.
+ *
+ * @param array    Pointer to the array
+ * @param element  Element size
+ * @param size     Array size
+ * @param count    Amount of elements to sort
+ * @param compare  Compare function
+ *
+ * @sa bh_sort, bh_nth_element
+ */
+void bh_partial_sort(void *array,
+                     size_t element,
+                     size_t size,
+                     size_t count,
+                     bh_compare_cb_t compare);
+
+/**
+ * Partition array around the nth element.
+ *
+ * Element, that would be placed at nth position in the sorted array, is
+ * placed at nth position. Elements before it are not greater, elements
+ * after it are not less. Uses introselect (quickselect with heap select
+ * fallback).
+ *
+ * @param array    Pointer to the array
+ * @param element  Element size
+ * @param size     Array size
+ * @param nth      Index of the element
+ * @param compare  Compare function
+ *
+ * @sa bh_sort, bh_partial_sort
+ */
+void bh_nth_element(void *array,
+                    size_t element,
+                    size_t size,
+                    size_t nth,
+                    bh_compare_cb_t compare);
+
+/**
+ * Partition array by the predicate.
+ *
+ * Elements, that satisfy the predicate, are moved before elements, that
+ * don't. Relative order of elements is not preserved. Predicate is called
+ * exactly once for each element.
+ *
+ * @param array      Pointer to the array
+ * @param element    Element size
+ * @param size       Array size
+ * @param predicate  Predicate function
+ * @param data       Predicate function data
+ * @return Amount of elements, that satisfy the predicate
+ *
+ * @sa bh_stable_partition
+ */
+size_t bh_partition(void *array,
+                    size_t element,
+                    size_t size,
+                    bh_predicate_cb_t predicate,
+                    void *data);
+
+/**
+ * Stable partition array by the predicate.
+ *
+ * Same as bh_partition, but relative order of elements is preserved. If
+ * scratch buffer is provided, partition is done in a single pass, otherwise
+ * elements are partitioned in-place with rotations (O(n log n) moves).
+ *
+ * @param array      Pointer to the array
+ * @param element    Element size
+ * @param size       Array size
+ * @param predicate  Predicate function
+ * @param data       Predicate function data
+ * @param scratch    Pointer to the scratch buffer (at least size elements)
+ *                   or null
+ * @return Amount of elements, that satisfy the predicate
+ *
+ * @sa bh_partition
+ */
+size_t bh_stable_partition(void *array,
+                           size_t element,
+                           size_t size,
+                           bh_predicate_cb_t predicate,
+                           void *data,
+                           void *scratch);
+
+/**
+ * Remove consecutive duplicate elements.
+ *
+ * Each group of consecutive equal elements is replaced with its first
+ * element. Remaining elements are moved to the beginning of the array, order
+ * of the elements is preserved.
+ *
+ * @param array    Pointer to the array
+ * @param element  Element size
+ * @param size     Array size
+ * @param compare  Compare function
+ * @return Amount of remaining elements
+ *
+ * @sa bh_sort, bh_array_remove_if
+ */
+size_t bh_unique(void *array,
+                 size_t element,
+                 size_t size,
+                 bh_compare_cb_t compare);
+
+/**
+ * Find first element in the sorted array, that is not less than the key.
+ *
+ * Uses branchless binary search.
+ *
+ * @param key      Pointer to the key
+ * @param array    Pointer to the array
+ * @param element  Element size
+ * @param size     Array size
+ * @param compare  Compare function
+ * @return Pointer to the element or pointer past the last element
+ *
+ * @sa bh_upper_bound, bh_equal_range
+ */
+void *bh_lower_bound(const void *key,
+                     void *array,
+                     size_t element,
+                     size_t size,
+                     bh_compare_cb_t compare);
+
+/**
+ * Find first element in the sorted array, that is greater than the key.
+ *
+ * Uses branchless binary search.
+ *
+ * @param key      Pointer to the key
+ * @param array    Pointer to the array
+ * @param element  Element size
+ * @param size     Array size
+ * @param compare  Compare function
+ * @return Pointer to the element or pointer past the last element
+ *
+ * @sa bh_lower_bound, bh_equal_range
+ */
+void *bh_upper_bound(const void *key,
+                     void *array,
+                     size_t element,
+                     size_t size,
+                     bh_compare_cb_t compare);
+
+/**
+ * Find range of elements in the sorted array, that are equal to the key.
+ *
+ * @param key      Pointer to the key
+ * @param array    Pointer to the array
+ * @param element  Element size
+ * @param size     Array size
+ * @param compare  Compare function
+ * @param first    Pointer to the first element of the range (lower bound)
+ * @param last     Pointer past the last element of the range (upper bound)
+ *
+ * @sa bh_lower_bound, bh_upper_bound
+ */
+void bh_equal_range(const void *key,
+                    void *array,
+                    size_t element,
+                    size_t size,
+                    bh_compare_cb_t compare,
+                    void **first,
+                    void **last);
+
+/**
+ * Copy sorted array into Eytzinger (BFS-order) layout.
+ *
+ * In Eytzinger layout children of the element at index i (1-based) are
+ * placed at indices 2i and 2i + 1, so the top levels of the search tree share
+ * few cache lines and the next levels can be prefetched.
+ *
+ * @param array    Pointer to the sorted array
+ * @param out      Pointer to the output array (same size as the array)
+ * @param element  Element size
+ * @param size     Array size
+ *
+ * @sa bh_eytzinger_lower_bound, bh_eytzinger_upper_bound
+ */
+void bh_eytzinger_make(const void *array,
+                       void *out,
+                       size_t element,
+                       size_t size);
+
+/**
+ * Find smallest element in the Eytzinger array, that is not less than the key.
+ *
+ * @param key      Pointer to the key
+ * @param array    Pointer to the array in Eytzinger layout
+ * @param element  Element size
+ * @param size     Array size
+ * @param compare  Compare function
+ * @return Pointer to the element or null if there is no such element
+ *
+ * @sa bh_eytzinger_make, bh_eytzinger_upper_bound
+ */
+void *bh_eytzinger_lower_bound(const void *key,
+                               void *array,
+                               size_t element,
+                               size_t size,
+                               bh_compare_cb_t compare);
+
+/**
+ * Find smallest element in the Eytzinger array, that is greater than the key.
+ *
+ * @param key      Pointer to the key
+ * @param array    Pointer to the array in Eytzinger layout
+ * @param element  Element size
+ * @param size     Array size
+ * @param compare  Compare function
+ * @return Pointer to the element or null if there is no such element
+ *
+ * @sa bh_eytzinger_make, bh_eytzinger_lower_bound
+ */
+void *bh_eytzinger_upper_bound(const void *key,
+                               void *array,
+                               size_t element,
+                               size_t size,
+                               bh_compare_cb_t compare);
+
+/**
+ * Merge multiple sorted runs.
+ *
+ * Runs are merged with the loser tree, which requires about log2(nruns)
+ * comparisons per element. Each run is described by the buffer of elements
+ * (data and size). When buffer is exhausted, optional refill function is
+ * called to load the next portion of the run (it should update data and size
+ * and return 0, or return non-zero when the run is finished), which allows
+ * merging streams.
+ *
+ * Merged elements are passed to the output function in order, elements with
+ * equal keys are passed in the order of their runs. Non-zero value returned
+ * by the output function stops merging.
+ *
+ * @param runs     Pointer to the array of runs
+ * @param nruns    Amount of runs
+ * @param element  Element size
+ * @param compare  Compare function
+ * @param out      Output function
+ * @param data     Output function data
+ * @return 0 on success, non-zero otherwise
+ *
+ * @sa bh_sort_stable
+ */
+int bh_merge_k(bh_merge_run_t *runs,
+               size_t nruns,
+               size_t element,
+               bh_compare_cb_t compare,
+               bh_merge_out_cb_t out,
+               void *data);
+
+/**
+ * Intersect two sorted arrays.
+ *
+ * Elements of the first array, that have equal elements in the second array,
+ * are copied into the output (each element of the second array matches at
+ * most one element of the first array). If one array is much smaller than
+ * the other, elements of the smaller array are searched in the larger one
+ * with galloping (exponential) search.
+ *
+ * @param a        Pointer to the first sorted array
+ * @param asize    First array size
+ * @param b        Pointer to the second sorted array
+ * @param bsize    Second array size
+ * @param out      Pointer to the output array (min(asize, bsize) elements)
+ * @param element  Element size
+ * @param compare  Compare function
+ * @return Amount of elements in the output
+ *
+ * @sa bh_set_union, bh_set_difference, bh_set_intersect32
+ */
+size_t bh_set_intersect(const void *a,
+                        size_t asize,
+                        const void *b,
+                        size_t bsize,
+                        void *out,
+                        size_t element,
+                        bh_compare_cb_t compare);
+
+/**
+ * Unite two sorted arrays.
+ *
+ * Elements of both arrays are merged into the output, equal elements are
+ * taken from the first array and output only once. If one array is much
+ * smaller than the other, blocks of the larger array are found with galloping
+ * search and copied at once.
+ *
+ * @param a        Pointer to the first sorted array
+ * @param asize    First array size
+ * @param b        Pointer to the second sorted array
+ * @param bsize    Second array size
+ * @param out      Pointer to the output array (asize + bsize elements)
+ * @param element  Element size
+ * @param compare  Compare function
+ * @return Amount of elements in the output
+ *
+ * @sa bh_set_intersect, bh_set_difference
+ */
+size_t bh_set_union(const void *a,
+                    size_t asize,
+                    const void *b,
+                    size_t bsize,
+                    void *out,
+                    size_t element,
+                    bh_compare_cb_t compare);
+
+/**
+ * Subtract one sorted array from another.
+ *
+ * Elements of the first array, that don't have equal elements in the second
+ * array, are copied into the output (each element of the second array
+ * removes at most one element of the first array). If one array is much
+ * smaller than the other, galloping search is used.
+ *
+ * @param a        Pointer to the first sorted array
+ * @param asize    First array size
+ * @param b        Pointer to the second sorted array
+ * @param bsize    Second array size
+ * @param out      Pointer to the output array (asize elements)
+ * @param element  Element size
+ * @param compare  Compare function
+ * @return Amount of elements in the output
+ *
+ * @sa bh_set_intersect, bh_set_union
+ */
+size_t bh_set_difference(const void *a,
+                         size_t asize,
+                         const void *b,
+                         size_t bsize,
+                         void *out,
+                         size_t element,
+                         bh_compare_cb_t compare);
+
+/**
+ * Intersect two sorted arrays of unsigned 32-bit integers.
+ *
+ * Arrays are compared by blocks with SIMD instructions (SSE2 for 32-bit and
+ * AVX2 for 64-bit elements, AVX2 is detected at runtime where supported),
+ * otherwise branchless merge is used. If one array is much smaller than the
+ * other, galloping search is used.
+ *
+ * @param a      Pointer to the first sorted array
+ * @param asize  First array size
+ * @param b      Pointer to the second sorted array
+ * @param bsize  Second array size
+ * @param out    Pointer to the output array (min(asize, bsize) elements)
+ * @return Amount of elements in the output
+ *
+ * @warning Arrays should not contain duplicates.
+ *
+ * @sa bh_set_intersect, bh_set_intersect64
+ */
+size_t bh_set_intersect32(const void *a,
+                          size_t asize,
+                          const void *b,
+                          size_t bsize,
+                          void *out);
+
+/**
+ * Intersect two sorted arrays of unsigned 64-bit integers.
+ *
+ * @param a      Pointer to the first sorted array
+ * @param asize  First array size
+ * @param b      Pointer to the second sorted array
+ * @param bsize  Second array size
+ * @param out    Pointer to the output array (min(asize, bsize) elements)
+ * @return Amount of elements in the output
+ *
+ * @warning Arrays should not contain duplicates.
+ *
+ * @sa bh_set_intersect, bh_set_intersect32
+ */
+size_t bh_set_intersect64(const void *a,
+                          size_t asize,
+                          const void *b,
+                          size_t bsize,
+                          void *out);
+
+/**
+ * Find first element bitwise equal to the item.
+ *
+ * For elements of 1, 2, 4 and 8 bytes, array is scanned with SIMD equality
+ * kernels (SSE2, or AVX2 if supported by the CPU at runtime), otherwise
+ * elements are compared with memcmp. Use bh_find_if, if elements can't be
+ * compared bitwise (e.g. have padding).
+ *
+ * @param item     Pointer to the item
+ * @param array    Pointer to the array
+ * @param element  Element size
+ * @param size     Array size
+ * @return Pointer to the element or null if there is no such element
+ *
+ * @sa bh_find_if, bh_count
+ */
+void *bh_find(const void *item,
+              void *array,
+              size_t element,
+              size_t size);
+
+/**
+ * Find first element equal to the item with the compare function.
+ *
+ * @param item     Pointer to the item
+ * @param array    Pointer to the array
+ * @param element  Element size
+ * @param size     Array size
+ * @param compare  Compare function
+ * @return Pointer to the element or null if there is no such element
+ *
+ * @sa bh_find
+ */
+void *bh_find_if(const void *item,
+                 void *array,
+                 size_t element,
+                 size_t size,
+                 bh_compare_cb_t compare);
+
+/**
+ * Count elements bitwise equal to the item.
+ *
+ * @param item     Pointer to the item
+ * @param array    Pointer to the array
+ * @param element  Element size
+ * @param size     Array size
+ * @return Amount of equal elements
+ *
+ * @sa bh_find
+ */
+size_t bh_count(const void *item,
+                const void *array,
+                size_t element,
+                size_t size);
+
+/**
+ * Sort file of fixed size records with bounded memory.
+ *
+ * Input is read in chunks that fit into memory limit, each chunk is sorted
+ * with bh_sort and spilled into the temporary file as a sorted run. Runs are
+ * then merged with bh_merge_k (in several passes if there are too many runs)
+ * into the output. Runs are read and output is written in large blocks.
+ *
+ * If the whole input fits into memory limit, no temporary files are created.
+ *
+ * @param in       Input file (read from the current position to the end)
+ * @param out      Output file
+ * @param element  Element size
+ * @param memory   Memory limit in bytes
+ * @param compare  Compare function
+ * @return 0 on success, non-zero otherwise
+ *
+ * @warning Input size should be a multiple of the element size.
+ *
+ * @sa bh_sort, bh_merge_k
+ */
+int bh_sort_external(FILE *in,
+                     FILE *out,
+                     size_t element,
+                     size_t memory,
+                     bh_compare_cb_t compare);
+
+/**
+ * Define heap functions specialized for the type.
+ *
+ * Defines static inline functions name_heap_make, name_heap_push and
+ * name_heap_pop, that mirror bh_heap_make, bh_heap_push and bh_heap_pop, but
+ * operate on the array of the concrete type and evaluate comparison inline.
+ * Elements are moved with assignments and sifting moves a hole instead of
+ * swapping elements on each level.
+ *
+ * Comparison expression should use pointers a and b (const type *) and
+ * evaluate to non-zero when a is less than b.
+ *
+ * @param name       Function name prefix
+ * @param type       Element type
+ * @param less_expr  Less-than expression
+ *
+ * @sa BH_SORT_DEFINE
+ */
+#define BH_HEAP_DEFINE(name, type, less_expr) \
+    static BH_INLINE int name##_less(const type *a, \
+                                     const type *b) \
+    { \
+        return (less_expr); \
+    } \
+    \
+    static BH_INLINE void name##_heap_sift(type *array, \
+                                           size_t index, \
+                                           size_t size, \
+                                           type value) \
+    { \
+        size_t child; \
+        \
+        /* Move hole down until value can be placed */ \
+        while ((child = index * 2 + 1) < size) \
+        { \
+            if (child + 1 < size && name##_less(array + child, array + child + 1)) \
+                child++; \
+            if (!name##_less(&value, array + child)) \
+                break; \
+            array[index] = array[child]; \
+            index = child; \
+        } \
+        array[index] = value; \
+    } \
+    \
+    static BH_INLINE void name##_heap_make(type *array, \
+                                           size_t size) \
+    { \
+        size_t i; \
+        \
+        for (i = size / 2; i--;) \
+            name##_heap_sift(array, i, size, array[i]); \
+    } \
+    \
+    static BH_INLINE void name##_heap_pop(type *array, \
+                                          size_t size) \
+    { \
+        type value; \
+        \
+        if (size <= 1) \
+            return; \
+        \
+        value = array[size - 1]; \
+        array[size - 1] = array[0]; \
+        name##_heap_sift(array, 0, size - 1, value); \
+    } \
+    \
+    static BH_INLINE void name##_heap_push(const type *value, \
+                                           type *array, \
+                                           size_t size) \
+    { \
+        size_t parent; \
+        \
+        /* Move hole up until value can be placed */ \
+        while (size) \
+        { \
+            parent = (size - 1) / 2; \
+            if (!name##_less(array + parent, value)) \
+                break; \
+            array[size] = array[parent]; \
+            size = parent; \
+        } \
+        array[size] = *value; \
+    }
+
+/**
+ * Define sort and heap functions specialized for the type.
+ *
+ * In addition to the functions defined by BH_HEAP_DEFINE, defines static
+ * inline function name_sort, that mirrors bh_sort. Sorting is done with
+ * introsort: quicksort with median of 3 pivot, insertion sort for small ranges
+ * and heap sort if recursion gets too deep.
+ *
+ * Example:
+ * @code
+ * BH_SORT_DEFINE(int_sort, int, *a < *b)
+ *
+ * int_sort_sort(array, size);
+ * @endcode
+ *
+ * @param name       Function name prefix
+ * @param type       Element type
+ * @param less_expr  Less-than expression
+ *
+ * @sa BH_HEAP_DEFINE, bh_sort
+ */
+#define BH_SORT_DEFINE(name, type, less_expr) \
+    BH_HEAP_DEFINE(name, type, less_expr) \
+    \
+    static BH_INLINE void name##_swap(type *a, \
+                                      type *b) \
+    { \
+        type value; \
+        \
+        value = *a; \
+        *a = *b; \
+        *b = value; \
+    } \
+    \
+    static BH_INLINE void name##_sort_insert(type *array, \
+                                             size_t size) \
+    { \
+        type value; \
+        size_t i, j; \
+        \
+        for (i = 1; i < size; i++) \
+        { \
+            value = array[i]; \
+            for (j = i; j && name##_less(&value, array + j - 1); j--) \
+                array[j] = array[j - 1]; \
+            array[j] = value; \
+        } \
+    } \
+    \
+    static BH_INLINE void name##_sort_loop(type *array, \
+                                           size_t size, \
+                                           size_t depth) \
+    { \
+        type pivot; \
+        size_t i, j; \
+        \
+        while (size > 16) \
+        { \
+            /* Recursion is too deep - fallback to heap sort */ \
+            if (!depth--) \
+            { \
+                name##_heap_make(array, size); \
+                while (size) \
+                    name##_heap_pop(array, size--); \
+                return; \
+            } \
+            \
+            /* Order first, middle and last elements, use median as pivot */ \
+            i = size / 2; \
+            j = size - 1; \
+            if (name##_less(array + i, array)) \
+                name##_swap(array + i, array); \
+            if (name##_less(array + j, array + i)) \
+                name##_swap(array + j, array + i); \
+            if (name##_less(array + i, array)) \
+                name##_swap(array + i, array); \
+            pivot = array[i]; \
+            array[i] = array[1]; \
+            array[1] = pivot; \
+            \
+            /* Partition, first and last elements act as sentinels */ \
+            i = 1; \
+            while (1) \
+            { \
+                do i++; while (name##_less(array + i, &pivot)); \
+                do j--; while (name##_less(&pivot, array + j)); \
+                if (i >= j) \
+                    break; \
+                name##_swap(array + i, array + j); \
+            } \
+            array[1] = array[j]; \
+            array[j] = pivot; \
+            \
+            /* Recurse into smaller part, iterate over the larger part */ \
+            if (j < size - j) \
+            { \
+                name##_sort_loop(array, j, depth); \
+                array += j + 1; \
+                size -= j + 1; \
+            } \
+            else \
+            { \
+                name##_sort_loop(array + j + 1, size - j - 1, depth); \
+                size = j; \
+            } \
+        } \
+        \
+        name##_sort_insert(array, size); \
+    } \
+    \
+    static BH_INLINE void name##_sort(type *array, \
+                                      size_t size) \
+    { \
+        size_t depth, i; \
+        \
+        for (depth = 0, i = size; i; i >>= 1) \
+            depth += 2; \
+        name##_sort_loop(array, size, depth); \
+    }
+
 #endif /* BHLIB_ALGO_H */
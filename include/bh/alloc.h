@@ -0,0 +1,241 @@
+/*
+ * BHLib
+ *
+ * Copyright (c) 2024 Mikhail Romanko
+ */
+
+/**
+ * @file bh/alloc.h
+ */
+
+#ifndef BHLIB_ALLOC_H
+#define BHLIB_ALLOC_H
+
+#include "bh.h"
+#include <stddef.h>
+
+#define BH_ARENA_CHUNK  65536
+#define BH_ARENA_ALIGN  (2 * sizeof(void *))
+
+typedef void *(*bh_alloc_cb_t)(void *, size_t);
+typedef void *(*bh_realloc_cb_t)(void *, void *, size_t, size_t);
+typedef void (*bh_free_cb_t)(void *, void *, size_t);
+
+typedef struct bh_allocator_s
+{
+    bh_alloc_cb_t alloc;
+    bh_realloc_cb_t realloc;
+    bh_free_cb_t free;
+    void *context;
+} bh_allocator_t;
+
+typedef struct bh_arena_chunk_s
+{
+    struct bh_arena_chunk_s *prev;
+    size_t size;
+} bh_arena_chunk_t;
+
+typedef struct
+{
+    size_t count;
+    size_t used;
+    size_t peak;
+    size_t capacity;
+    size_t chunks;
+} bh_arena_stats_t;
+
+typedef struct
+{
+    bh_arena_chunk_t *chunk;
+    char *current;
+    size_t count;
+    size_t used;
+} bh_arena_mark_t;
+
+typedef struct bh_arena_s
+{
+    bh_arena_chunk_t *chunk;
+    bh_arena_chunk_t *spare;
+    char *current;
+    char *end;
+    size_t chunk_size;
+    bh_arena_stats_t stats;
+    const bh_allocator_t *backing;
+    bh_allocator_t allocator;
+} bh_arena_t;
+
+/**
+ * Return default allocator.
+ *
+ * Default allocator uses malloc, realloc and free from the C library.
+ *
+ * @return Pointer to the default allocator
+ */
+const bh_allocator_t *bh_allocator_default(void);
+
+/**
+ * Allocate memory with the allocator.
+ *
+ * Allocator callback receives allocator context and requested size.
+ *
+ * @param allocator  Pointer to the allocator or null (default allocator)
+ * @param size       Size in bytes
+ * @return Pointer to the memory or null
+ *
+ * @sa bh_realloc, bh_free
+ */
+void *bh_alloc(const bh_allocator_t *allocator,
+               size_t size);
+
+/**
+ * Reallocate memory with the allocator.
+ *
+ * Allocator callback receives allocator context, pointer, old and new size.
+ * If allocator doesn't provide realloc callback, memory is allocated, copied
+ * and freed.
+ *
+ * @param allocator  Pointer to the allocator or null (default allocator)
+ * @param ptr        Pointer to the memory or null
+ * @param old_size   Current size in bytes
+ * @param size       New size in bytes
+ * @return Pointer to the memory or null (memory is not freed)
+ *
+ * @sa bh_alloc, bh_free
+ */
+void *bh_realloc(const bh_allocator_t *allocator,
+                 void *ptr,
+                 size_t old_size,
+                 size_t size);
+
+/**
+ * Free memory with the allocator.
+ *
+ * Allocator callback receives allocator context, pointer and size of the
+ * memory (as it was allocated), which allows sized deallocation.
+ *
+ * @param allocator  Pointer to the allocator or null (default allocator)
+ * @param ptr        Pointer to the memory or null
+ * @param size       Size in bytes
+ *
+ * @sa bh_alloc, bh_realloc
+ */
+void bh_free(const bh_allocator_t *allocator,
+             void *ptr,
+             size_t size);
+
+/**
+ * Initialize arena.
+ *
+ * Arena (region) allocator serves allocations by advancing pointer inside of
+ * large chunks. Individual allocations are not freed, instead everything
+ * allocated after the mark is released at once with bh_arena_reset_to.
+ * Chunks are allocated lazily with the backing allocator.
+ *
+ * @param arena       Pointer to the arena
+ * @param chunk_size  Chunk size in bytes (0 for default BH_ARENA_CHUNK)
+ * @param backing     Pointer to the backing allocator or null (default)
+ *
+ * @warning Arena can't be moved after bh_arena_allocator was called.
+ *
+ * @sa bh_arena_destroy, bh_arena_alloc, bh_arena_allocator
+ */
+void bh_arena_init(bh_arena_t *arena,
+                   size_t chunk_size,
+                   const bh_allocator_t *backing);
+
+/**
+ * Destroy arena.
+ *
+ * All memory allocated from the arena is freed.
+ *
+ * @param arena  Pointer to the arena
+ */
+void bh_arena_destroy(bh_arena_t *arena);
+
+/**
+ * Allocate memory from the arena with default alignment (BH_ARENA_ALIGN).
+ *
+ * @param arena  Pointer to the arena
+ * @param size   Size in bytes
+ * @return Pointer to the memory or null
+ *
+ * @sa bh_arena_alloc_aligned, bh_arena_reset_to
+ */
+void *bh_arena_alloc(bh_arena_t *arena,
+                     size_t size);
+
+/**
+ * Allocate memory from the arena with specified alignment.
+ *
+ * @param arena  Pointer to the arena
+ * @param size   Size in bytes
+ * @param align  Alignment (power of two)
+ * @return Pointer to the memory or null
+ *
+ * @sa bh_arena_alloc
+ */
+void *bh_arena_alloc_aligned(bh_arena_t *arena,
+                             size_t size,
+                             size_t align);
+
+/**
+ * Remember current arena position.
+ *
+ * @param arena  Pointer to the arena
+ * @param mark   Pointer to the mark
+ *
+ * @sa bh_arena_reset_to
+ */
+void bh_arena_mark(const bh_arena_t *arena,
+                   bh_arena_mark_t *mark);
+
+/**
+ * Free everything allocated after the mark.
+ *
+ * Chunks allocated after the mark are released (the last one is kept as a
+ * spare chunk to avoid allocation on the next use). Marks taken after this
+ * mark become invalid.
+ *
+ * @param arena  Pointer to the arena
+ * @param mark   Pointer to the mark
+ *
+ * @sa bh_arena_mark, bh_arena_reset
+ */
+void bh_arena_reset_to(bh_arena_t *arena,
+                       const bh_arena_mark_t *mark);
+
+/**
+ * Free everything allocated from the arena.
+ *
+ * @param arena  Pointer to the arena
+ *
+ * @sa bh_arena_reset_to
+ */
+void bh_arena_reset(bh_arena_t *arena);
+
+/**
+ * Return allocator interface of the arena.
+ *
+ * Allows containers to allocate from the arena (see bh_array_init_alloc).
+ * Freeing the last allocation or growing it in-place is supported, other
+ * frees are ignored until the arena is reset.
+ *
+ * @param arena  Pointer to the arena
+ * @return Pointer to the allocator
+ */
+const bh_allocator_t *bh_arena_allocator(bh_arena_t *arena);
+
+/**
+ * Return arena statistics.
+ *
+ * Statistics contain amount of allocations (count), allocated bytes
+ * including alignment padding (used), peak of used bytes (peak), bytes held
+ * in chunks (capacity) and amount of chunks (chunks).
+ *
+ * @param arena  Pointer to the arena
+ * @return Pointer to the statistics
+ */
+#define bh_arena_stats(arena) \
+    ((const bh_arena_stats_t *)&(arena)->stats)
+
+#endif /* BHLIB_ALLOC_H */
@@ -10,7 +10,19 @@
 #include <bh/config.h>
 #include <stddef.h>
 
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L
+#define BH_INLINE inline
+#elif defined(__GNUC__) || defined(_MSC_VER)
+#define BH_INLINE __inline
+#else
+#define BH_INLINE
+#endif
+
 typedef int (*bh_compare_cb_t)(const void *, const void *);
 typedef size_t (*bh_hash_cb_t)(const void *);
+typedef void (*bh_swap_cb_t)(void *, void *, size_t);
+typedef int (*bh_predicate_cb_t)(const void *, void *);
+
+typedef struct bh_tpool_s bh_tpool_t;
 
 #endif /* BHLIB_H */
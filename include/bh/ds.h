@@ -12,16 +12,62 @@
 #define BHLIB_DS_H
 
 #include "bh.h"
+#include "alloc.h"
 #include <stddef.h>
 
+#define BH_PQUEUE_ARITY 4
+#define BH_GROWTH_DEFAULT 200
+#define BH_GROWTH_MIN 16
+#define BH_SEGARRAY_SHIFT 4
+#define BH_SEGARRAY_SEGMENTS (sizeof(size_t) * 8 - BH_SEGARRAY_SHIFT)
+#define BH_COLUMNS_MAX 32
+
 typedef struct
 {
     void *data;
     size_t size;
     size_t capacity;
     size_t element;
+    size_t growth;
+    const bh_allocator_t *allocator;
 } bh_array_t;
 
+typedef struct
+{
+    bh_array_t base;
+    void *buffer;
+    size_t fixed;
+} bh_sarray_t;
+
+typedef struct
+{
+    void *segments[BH_SEGARRAY_SEGMENTS];
+    size_t count;
+    size_t size;
+    size_t capacity;
+    size_t element;
+    const bh_allocator_t *allocator;
+} bh_segarray_t;
+
+typedef struct
+{
+    void *data;
+    size_t size;
+    size_t capacity;
+    const bh_allocator_t *allocator;
+} bh_bitset_t;
+
+typedef struct
+{
+    void *data[BH_COLUMNS_MAX];
+    size_t element[BH_COLUMNS_MAX];
+    size_t count;
+    size_t size;
+    size_t capacity;
+    size_t growth;
+    const bh_allocator_t *allocator;
+} bh_columns_t;
+
 typedef struct
 {
     struct
@@ -41,6 +87,7 @@ typedef struct
 
     bh_compare_cb_t compare;
     bh_hash_cb_t hash;
+    const bh_allocator_t *allocator;
 } bh_map_t;
 
 typedef struct bh_queue_s
@@ -50,8 +97,33 @@ typedef struct bh_queue_s
     size_t element;
     size_t head;
     size_t tail;
+    size_t growth;
+    const bh_allocator_t *allocator;
 } bh_queue_t;
 
+typedef struct
+{
+    void *data;
+    size_t size;
+    size_t capacity;
+    size_t element;
+    bh_compare_cb_t compare;
+    const bh_allocator_t *allocator;
+    int sorted;
+} bh_topk_t;
+
+typedef struct
+{
+    void *data;
+    size_t size;
+    size_t capacity;
+    size_t element;
+    size_t arity;
+    size_t growth;
+    bh_compare_cb_t compare;
+    const bh_allocator_t *allocator;
+} bh_pqueue_t;
+
 /**
  * Initialize the array with the specified element size.
  *
@@ -65,6 +137,21 @@ typedef struct bh_queue_s
 void bh_array_init(bh_array_t *array,
                    size_t element);
 
+/**
+ * Initialize the array with the specified element size and allocator.
+ *
+ * @param array      Pointer to the array
+ * @param element    Element size
+ * @param allocator  Pointer to the allocator or null (default allocator)
+ *
+ * @warning Allocator should outlive the array.
+ *
+ * @sa bh_array_init, bh_allocator_default
+ */
+void bh_array_init_alloc(bh_array_t *array,
+                         size_t element,
+                         const bh_allocator_t *allocator);
+
 /**
  * Destroy array.
  *
@@ -72,162 +159,1137 @@ void bh_array_init(bh_array_t *array,
  *
  * @param array  Pointer to the array
  *
- * @warning If array's elements require custom destruction (by calling their
- *          respective destroy function) - then user should iterate over an
- *          array to manually destroy elements.
+ * @warning If array's elements require custom destruction (by calling their
+ *          respective destroy function) - then user should iterate over an
+ *          array to manually destroy elements.
+ *
+ * @sa bh_array_clear, bh_array_remove
+ */
+void bh_array_destroy(bh_array_t *array);
+
+/**
+ * Reset array size counter to zero.
+ *
+ * @param array  Pointer to the array
+ *
+ * @warning If array's elements require custom destruction (by calling their
+ *          respective destroy function) - then user should iterate over an
+ *          array to manually destroy elements.
+ *
+ * @sa bh_array_destroy, bh_array_remove
+ */
+void bh_array_clear(bh_array_t *array);
+
+/**
+ * Reserve memory for the array to store required elements.
+ *
+ * @param array  Pointer to the array
+ * @param size   Anticipated array size
+ *
+ * @return 0 on success, non-zero otherwise
+ *
+ * @sa bh_array_capacity, bh_array_resize
+ */
+int bh_array_reserve(bh_array_t *array,
+                     size_t size);
+
+/**
+ * Set array growth factor.
+ *
+ * When array runs out of capacity, new capacity is calculated as current
+ * capacity multiplied by growth factor (in percents), but not less than
+ * BH_GROWTH_MIN elements. Default growth factor is BH_GROWTH_DEFAULT.
+ *
+ * @param array   Pointer to the array
+ * @param growth  Growth factor in percents (should be greater than 100)
+ *
+ * @sa bh_array_reserve, bh_array_insert
+ */
+void bh_array_set_growth(bh_array_t *array,
+                         size_t growth);
+
+/**
+ * Changes array's size.
+ *
+ * In case where new size is bigger then array's capacity - bh_array_reserve
+ * will be called implicitly.
+ *
+ * @param array  Pointer to the array
+ * @param size   New size of the array
+ *
+ * @return 0 on success, non-zero otherwise
+ *
+ * @warning In case of array growing - inserted items are not initialized.
+ * @warning In case of array shrinking - removed items are not destroyed.
+ *
+ * @sa bh_array_reserve, bh_array_size
+ */
+int bh_array_resize(bh_array_t *array,
+                    size_t size);
+
+/**
+ * Prepare space in array for the new element at specified index.
+ *
+ * @param array  Pointer to the array
+ * @param index  Index
+ * @return Non-null iterator on success, null otherwise
+ *
+ * @warning If index value greater-or-equal to array size - element
+ *          will be inserted at the back of an array.
+ *
+ * @warning Inserted element are not initialized.
+ *
+ * @sa bh_array_remove, bh_array_next, bh_array_value
+ */
+void *bh_array_insert(bh_array_t *array,
+                      size_t index);
+
+/**
+ * Prepare space in array for the multiple new elements at specified index.
+ *
+ * Array is reserved at most once and the tail is shifted with single move.
+ *
+ * @param array  Pointer to the array
+ * @param index  Index
+ * @param count  Amount of elements
+ * @return Non-null iterator to the first element on success, null otherwise
+ *
+ * @warning If index value greater-or-equal to array size - elements
+ *          will be inserted at the back of an array.
+ *
+ * @warning Inserted elements are not initialized.
+ *
+ * @sa bh_array_insert, bh_array_append, bh_array_erase_range
+ */
+void *bh_array_insert_n(bh_array_t *array,
+                        size_t index,
+                        size_t count);
+
+/**
+ * Append elements to the back of the array.
+ *
+ * @param array  Pointer to the array
+ * @param src    Pointer to the elements (can point into the array)
+ * @param count  Amount of elements
+ * @return 0 on success, non-zero otherwise
+ *
+ * @sa bh_array_insert_n
+ */
+int bh_array_append(bh_array_t *array,
+                    const void *src,
+                    size_t count);
+
+/**
+ * Remove range of elements [first, last).
+ *
+ * Elements to the right of the range are shifted left with single move.
+ *
+ * @param array  Pointer to the array
+ * @param first  Iterator to the first removed element
+ * @param last   Iterator past the last removed element
+ * @return Iterator to the next element or null if reached the end
+ *
+ * @warning Removed elements are not destroyed.
+ *
+ * @sa bh_array_remove, bh_array_insert_n
+ */
+void *bh_array_erase_range(bh_array_t *array,
+                           void *first,
+                           void *last);
+
+/**
+ * Return iterator to the specified index.
+ *
+ * @param array  Pointer to the array
+ * @param index  Index
+ * @return Non-null iterator on success, null otherwise
+ *
+ * @sa bh_array_next, bh_array_value, bh_array_remove
+ */
+void *bh_array_at(bh_array_t *array,
+                  size_t index);
+
+/**
+ * Remove element by iterator.
+ *
+ * All elements to the right of the element pointed by iterator
+ * will be shifted left.
+ *
+ * @param array  Pointer to the array
+ * @param iter   Iterator
+ * @return Iterator to the next element or null if reached the end
+ *
+ * @warning Removed element are not destroyed.
+ *
+ * @sa bh_array_at, bh_array_insert, bh_array_next, bh_array_value
+ */
+void *bh_array_remove(bh_array_t *array,
+                      void *iter);
+
+/**
+ * Remove elements, that satisfy the predicate.
+ *
+ * Remaining elements are compacted in a single pass (runs of remaining
+ * elements are moved at once), order of the elements is preserved.
+ *
+ * @param array      Pointer to the array
+ * @param predicate  Predicate function
+ * @param data       Predicate function data
+ * @return Amount of removed elements
+ *
+ * @warning Removed element are not destroyed.
+ *
+ * @sa bh_array_remove
+ */
+size_t bh_array_remove_if(bh_array_t *array,
+                          bh_predicate_cb_t predicate,
+                          void *data);
+
+/**
+ * Return iterator to the next element.
+ *
+ * If passed NULL-iterator, then iterator for the first element will
+ * be returned.
+ *
+ * @param array  Pointer to the array
+ * @param iter   Iterator
+ * @return Iterator to the next element or null if reached the end
+ *
+ * @sa bh_array_value, bh_array_remove
+ */
+void *bh_array_next(bh_array_t *array,
+                    void *iter);
+
+/**
+ * Return pointer to the array value.
+ *
+ * @param array  Pointer to the array
+ * @param iter   Iterator
+ * @return Pointer to the array value
+ *
+ * @sa bh_array_next, bh_array_remove
+ */
+void *bh_array_value(bh_array_t *array,
+                     void *iter);
+
+/**
+ * Return array size
+ *
+ * @param array  Pointer to the array
+ * @return Array size
+ *
+ * @sa bh_array_capacity
+ */
+#define bh_array_size(array) \
+    (array)->size
+
+/**
+ * Return array capacity.
+ *
+ * @param array  Pointer to the array
+ * @return Array capacity
+ *
+ * @sa bh_array_size
+ */
+#define bh_array_capacity(array) \
+    (array)->capacity
+
+/**
+ * Return pointer to the beginning of the data.
+ *
+ * @param array  Pointer to the array
+ * @return Pointer to the data or null (if array doesn't have capacity)
+ */
+#define bh_array_data(array) \
+    (array)->data
+
+/**
+ * Declare structure with small array and its inline buffer.
+ *
+ * Example:
+ * @code
+ * BH_SARRAY(int, 8) ids;
+ *
+ * bh_sarray_init(&ids.array, sizeof(int), ids.buffer, 8);
+ * @endcode
+ *
+ * @param type   Element type
+ * @param count  Inline buffer capacity
+ */
+#define BH_SARRAY(type, count) \
+    struct { bh_sarray_t array; type buffer[count]; }
+
+/**
+ * Initialize small array with the specified element size and inline buffer.
+ *
+ * Small array stores elements in the inline buffer (provided by the caller,
+ * e.g. on the stack or inside of the parent structure) and allocates memory
+ * on the heap only if elements don't fit into it. API mirrors bh_array_t.
+ *
+ * @param array     Pointer to the small array
+ * @param element   Element size
+ * @param buffer    Pointer to the inline buffer or null
+ * @param capacity  Inline buffer capacity
+ *
+ * @warning Small array points to the inline buffer, so it can't be copied or
+ *          moved with memcpy, if the buffer is a part of the same structure.
+ *
+ * @sa bh_sarray_destroy, BH_SARRAY
+ */
+void bh_sarray_init(bh_sarray_t *array,
+                    size_t element,
+                    void *buffer,
+                    size_t capacity);
+
+/**
+ * Initialize small array with the allocator for the heap memory.
+ *
+ * @param array      Pointer to the small array
+ * @param element    Element size
+ * @param buffer     Pointer to the inline buffer or null
+ * @param capacity   Inline buffer capacity
+ * @param allocator  Pointer to the allocator or null (default allocator)
+ *
+ * @sa bh_sarray_init, bh_array_init_alloc
+ */
+void bh_sarray_init_alloc(bh_sarray_t *array,
+                          size_t element,
+                          void *buffer,
+                          size_t capacity,
+                          const bh_allocator_t *allocator);
+
+/**
+ * Destroy small array.
+ *
+ * Heap memory allocated by the small array will be freed.
+ *
+ * @param array  Pointer to the small array
+ *
+ * @sa bh_sarray_clear
+ */
+void bh_sarray_destroy(bh_sarray_t *array);
+
+/**
+ * Reset small array size counter to zero.
+ *
+ * @param array  Pointer to the small array
+ *
+ * @sa bh_sarray_destroy
+ */
+void bh_sarray_clear(bh_sarray_t *array);
+
+/**
+ * Reserve memory for the small array to store required elements.
+ *
+ * If required elements fit into the inline buffer, elements are moved back
+ * into it and heap memory is freed.
+ *
+ * @param array  Pointer to the small array
+ * @param size   Anticipated array size
+ * @return 0 on success, non-zero otherwise
+ *
+ * @sa bh_sarray_capacity, bh_sarray_resize
+ */
+int bh_sarray_reserve(bh_sarray_t *array,
+                      size_t size);
+
+/**
+ * Set small array growth factor.
+ *
+ * @param array   Pointer to the small array
+ * @param growth  Growth factor in percents (should be greater than 100)
+ *
+ * @sa bh_array_set_growth
+ */
+void bh_sarray_set_growth(bh_sarray_t *array,
+                          size_t growth);
+
+/**
+ * Change small array size.
+ *
+ * @param array  Pointer to the small array
+ * @param size   New size of the array
+ * @return 0 on success, non-zero otherwise
+ *
+ * @warning In case of array growing - inserted items are not initialized.
+ * @warning In case of array shrinking - removed items are not destroyed.
+ *
+ * @sa bh_sarray_reserve, bh_sarray_size
+ */
+int bh_sarray_resize(bh_sarray_t *array,
+                     size_t size);
+
+/**
+ * Insert element at specified index in the small array.
+ *
+ * @param array  Pointer to the small array
+ * @param index  Index
+ * @return Non-null iterator on success, null otherwise
+ *
+ * @warning Inserted element is not initialized.
+ *
+ * @sa bh_sarray_remove, bh_sarray_at
+ */
+void *bh_sarray_insert(bh_sarray_t *array,
+                       size_t index);
+
+/**
+ * Prepare space in small array for the multiple new elements.
+ *
+ * @param array  Pointer to the small array
+ * @param index  Index
+ * @param count  Amount of elements
+ * @return Non-null iterator to the first element on success, null otherwise
+ *
+ * @warning Inserted elements are not initialized.
+ *
+ * @sa bh_array_insert_n
+ */
+void *bh_sarray_insert_n(bh_sarray_t *array,
+                         size_t index,
+                         size_t count);
+
+/**
+ * Append elements to the back of the small array.
+ *
+ * @param array  Pointer to the small array
+ * @param src    Pointer to the elements (can point into the array)
+ * @param count  Amount of elements
+ * @return 0 on success, non-zero otherwise
+ *
+ * @sa bh_array_append
+ */
+int bh_sarray_append(bh_sarray_t *array,
+                     const void *src,
+                     size_t count);
+
+/**
+ * Remove range of elements [first, last) from the small array.
+ *
+ * @param array  Pointer to the small array
+ * @param first  Iterator to the first removed element
+ * @param last   Iterator past the last removed element
+ * @return Iterator to the next element or null if reached the end
+ *
+ * @warning Removed elements are not destroyed.
+ *
+ * @sa bh_array_erase_range
+ */
+void *bh_sarray_erase_range(bh_sarray_t *array,
+                            void *first,
+                            void *last);
+
+/**
+ * Return iterator to the element at specified index.
+ *
+ * @param array  Pointer to the small array
+ * @param index  Index
+ * @return Non-null iterator on success, null otherwise
+ *
+ * @sa bh_sarray_insert, bh_sarray_value
+ */
+void *bh_sarray_at(bh_sarray_t *array,
+                   size_t index);
+
+/**
+ * Remove element by iterator.
+ *
+ * @param array  Pointer to the small array
+ * @param iter   Iterator
+ * @return Iterator to the next element or null if reached the end
+ *
+ * @warning Removed element are not destroyed.
+ *
+ * @sa bh_sarray_insert, bh_sarray_remove_if
+ */
+void *bh_sarray_remove(bh_sarray_t *array,
+                       void *iter);
+
+/**
+ * Remove elements, that satisfy the predicate.
+ *
+ * @param array      Pointer to the small array
+ * @param predicate  Predicate function
+ * @param data       Predicate function data
+ * @return Amount of removed elements
+ *
+ * @warning Removed element are not destroyed.
+ *
+ * @sa bh_array_remove_if
+ */
+size_t bh_sarray_remove_if(bh_sarray_t *array,
+                           bh_predicate_cb_t predicate,
+                           void *data);
+
+/**
+ * Return iterator to the next element.
+ *
+ * @param array  Pointer to the small array
+ * @param iter   Iterator
+ * @return Iterator to the next element or null if reached the end
+ *
+ * @sa bh_sarray_value
+ */
+void *bh_sarray_next(bh_sarray_t *array,
+                     void *iter);
+
+/**
+ * Return pointer to the small array value.
+ *
+ * @param array  Pointer to the small array
+ * @param iter   Iterator
+ * @return Pointer to the value
+ *
+ * @sa bh_sarray_next
+ */
+void *bh_sarray_value(bh_sarray_t *array,
+                      void *iter);
+
+/**
+ * Return small array size.
+ *
+ * @param array  Pointer to the small array
+ * @return Array size
+ */
+#define bh_sarray_size(array) \
+    (array)->base.size
+
+/**
+ * Return small array capacity.
+ *
+ * @param array  Pointer to the small array
+ * @return Array capacity
+ */
+#define bh_sarray_capacity(array) \
+    (array)->base.capacity
+
+/**
+ * Return pointer to the beginning of the data.
+ *
+ * @param array  Pointer to the small array
+ * @return Pointer to the data (inline buffer or heap memory)
+ */
+#define bh_sarray_data(array) \
+    (array)->base.data
+
+/**
+ * Initialize segmented array with the specified element size.
+ *
+ * Segmented array stores elements in segments, where segment k holds
+ * 2^(k + BH_SEGARRAY_SHIFT) elements. Growing the array allocates new
+ * segments and never moves existing elements, so pointers returned by
+ * bh_segarray_at and bh_segarray_push_back stay valid until elements are
+ * removed.
+ *
+ * @param array    Pointer to the segmented array
+ * @param element  Element size
+ *
+ * @sa bh_segarray_init_alloc, bh_segarray_destroy
+ */
+void bh_segarray_init(bh_segarray_t *array,
+                      size_t element);
+
+/**
+ * Initialize segmented array with the specified element size and allocator.
+ *
+ * @param array      Pointer to the segmented array
+ * @param element    Element size
+ * @param allocator  Pointer to the allocator or null (default allocator)
+ *
+ * @sa bh_segarray_init, bh_segarray_destroy
+ */
+void bh_segarray_init_alloc(bh_segarray_t *array,
+                            size_t element,
+                            const bh_allocator_t *allocator);
+
+/**
+ * Destroy segmented array.
+ *
+ * @param array  Pointer to the segmented array
+ *
+ * @warning Elements are not destroyed.
+ */
+void bh_segarray_destroy(bh_segarray_t *array);
+
+/**
+ * Clear segmented array. Segments are kept allocated.
+ *
+ * @param array  Pointer to the segmented array
+ *
+ * @warning Elements are not destroyed.
+ */
+void bh_segarray_clear(bh_segarray_t *array);
+
+/**
+ * Reserve memory for the segmented array to store required elements.
+ *
+ * If requested capacity is less then current one, unused segments past
+ * the array size are freed.
+ *
+ * @param array  Pointer to the segmented array
+ * @param size   Anticipated array size
+ * @return 0 on success, non-zero otherwise
+ *
+ * @sa bh_segarray_capacity, bh_segarray_resize
+ */
+int bh_segarray_reserve(bh_segarray_t *array,
+                        size_t size);
+
+/**
+ * Change segmented array's size.
+ *
+ * @param array  Pointer to the segmented array
+ * @param size   New size of the array
+ * @return 0 on success, non-zero otherwise
+ *
+ * @warning In case of array growing - inserted items are not initialized.
+ * @warning In case of array shrinking - removed items are not destroyed.
+ *
+ * @sa bh_segarray_reserve, bh_segarray_size
+ */
+int bh_segarray_resize(bh_segarray_t *array,
+                       size_t size);
+
+/**
+ * Prepare space for the new element at the end of the segmented array.
+ *
+ * @param array  Pointer to the segmented array
+ * @return Pointer to the new element or null
+ *
+ * @sa bh_segarray_pop_back, bh_segarray_append
+ */
+void *bh_segarray_push_back(bh_segarray_t *array);
+
+/**
+ * Remove last element of the segmented array.
+ *
+ * @param array  Pointer to the segmented array
+ *
+ * @warning Removed element is not destroyed.
+ */
+void bh_segarray_pop_back(bh_segarray_t *array);
+
+/**
+ * Append elements to the end of the segmented array.
+ *
+ * @param array  Pointer to the segmented array
+ * @param src    Pointer to the elements
+ * @param count  Amount of elements
+ * @return 0 on success, non-zero otherwise
+ *
+ * @sa bh_segarray_push_back
+ */
+int bh_segarray_append(bh_segarray_t *array,
+                       const void *src,
+                       size_t count);
+
+/**
+ * Return pointer to the element at specified index.
+ *
+ * @param array  Pointer to the segmented array
+ * @param index  Index
+ * @return Pointer to the element or null
+ *
+ * @sa bh_segarray_span
+ */
+void *bh_segarray_at(bh_segarray_t *array,
+                     size_t index);
+
+/**
+ * Return pointer to the contiguous run of elements starting at index.
+ *
+ * Example:
+ * @code
+ * size_t i, j, count;
+ * int *data;
+ *
+ * for (i = 0; i < bh_segarray_size(&array); i += count)
+ * {
+ *     data = bh_segarray_span(&array, i, &count);
+ *     for (j = 0; j < count; j++)
+ *         process(data[j]);
+ * }
+ * @endcode
+ *
+ * @param array  Pointer to the segmented array
+ * @param index  Index
+ * @param count  Pointer to the amount of elements in the run
+ * @return Pointer to the element or null
+ *
+ * @sa bh_segarray_at
+ */
+void *bh_segarray_span(bh_segarray_t *array,
+                       size_t index,
+                       size_t *count);
+
+/**
+ * Return segmented array size.
+ *
+ * @param array  Pointer to the segmented array
+ * @return Array size
+ */
+#define bh_segarray_size(array) \
+    (array)->size
+
+/**
+ * Return segmented array capacity.
+ *
+ * @param array  Pointer to the segmented array
+ * @return Array capacity
+ */
+#define bh_segarray_capacity(array) \
+    (array)->capacity
+
+/**
+ * Initialize bitset.
+ *
+ * Bits are stored in 64-bit words. Bulk operations and population count
+ * use SSE2/AVX2/POPCNT kernels, selected at runtime where supported.
+ *
+ * @param bitset  Pointer to the bitset
+ *
+ * @sa bh_bitset_init_alloc, bh_bitset_destroy
+ */
+void bh_bitset_init(bh_bitset_t *bitset);
+
+/**
+ * Initialize bitset with the specified allocator.
+ *
+ * @param bitset     Pointer to the bitset
+ * @param allocator  Pointer to the allocator or null (default allocator)
+ *
+ * @sa bh_bitset_init, bh_bitset_destroy
+ */
+void bh_bitset_init_alloc(bh_bitset_t *bitset,
+                          const bh_allocator_t *allocator);
+
+/**
+ * Destroy bitset.
+ *
+ * @param bitset  Pointer to the bitset
+ */
+void bh_bitset_destroy(bh_bitset_t *bitset);
+
+/**
+ * Clear bitset (set its size to zero).
+ *
+ * @param bitset  Pointer to the bitset
+ *
+ * @sa bh_bitset_fill
+ */
+void bh_bitset_clear(bh_bitset_t *bitset);
+
+/**
+ * Reserve memory for the bitset to store required amount of bits.
+ *
+ * @param bitset  Pointer to the bitset
+ * @param size    Anticipated amount of bits
+ * @return 0 on success, non-zero otherwise
+ *
+ * @sa bh_bitset_resize
+ */
+int bh_bitset_reserve(bh_bitset_t *bitset,
+                      size_t size);
+
+/**
+ * Change amount of bits in the bitset.
+ *
+ * New bits are cleared.
+ *
+ * @param bitset  Pointer to the bitset
+ * @param size    New amount of bits
+ * @return 0 on success, non-zero otherwise
+ *
+ * @sa bh_bitset_reserve, bh_bitset_size
+ */
+int bh_bitset_resize(bh_bitset_t *bitset,
+                     size_t size);
+
+/**
+ * Set bit at specified index.
+ *
+ * @param bitset  Pointer to the bitset
+ * @param index   Bit index (should be less then bitset size)
+ *
+ * @sa bh_bitset_reset, bh_bitset_test
+ */
+void bh_bitset_set(bh_bitset_t *bitset,
+                   size_t index);
+
+/**
+ * Clear bit at specified index.
+ *
+ * @param bitset  Pointer to the bitset
+ * @param index   Bit index (should be less then bitset size)
+ *
+ * @sa bh_bitset_set, bh_bitset_test
+ */
+void bh_bitset_reset(bh_bitset_t *bitset,
+                     size_t index);
+
+/**
+ * Test bit at specified index.
+ *
+ * @param bitset  Pointer to the bitset
+ * @param index   Bit index (should be less then bitset size)
+ * @return 1 if bit is set, 0 otherwise
+ *
+ * @sa bh_bitset_set, bh_bitset_reset
+ */
+int bh_bitset_test(const bh_bitset_t *bitset,
+                   size_t index);
+
+/**
+ * Set or clear all bits.
+ *
+ * @param bitset  Pointer to the bitset
+ * @param value   Non-zero to set bits, zero to clear them
+ */
+void bh_bitset_fill(bh_bitset_t *bitset,
+                    int value);
+
+/**
+ * Return amount of set bits.
+ *
+ * @param bitset  Pointer to the bitset
+ * @return Amount of set bits
+ *
+ * @sa bh_bitset_rank
+ */
+size_t bh_bitset_count(const bh_bitset_t *bitset);
+
+/**
+ * Find next set bit starting from the specified index.
+ *
+ * Example:
+ * @code
+ * size_t i;
+ *
+ * for (i = bh_bitset_next(&mask, 0); i < bh_bitset_size(&mask); i = bh_bitset_next(&mask, i + 1))
+ *     process(i);
+ * @endcode
+ *
+ * @param bitset  Pointer to the bitset
+ * @param index   Index to start from (inclusive)
+ * @return Index of the set bit or bitset size if there is none
+ */
+size_t bh_bitset_next(const bh_bitset_t *bitset,
+                      size_t index);
+
+/**
+ * Return amount of set bits before the specified index.
+ *
+ * @param bitset  Pointer to the bitset
+ * @param index   Index (exclusive)
+ * @return Amount of set bits in range [0; index)
+ *
+ * @sa bh_bitset_select
+ */
+size_t bh_bitset_rank(const bh_bitset_t *bitset,
+                      size_t index);
+
+/**
+ * Find index of the set bit with specified rank.
+ *
+ * @param bitset  Pointer to the bitset
+ * @param rank    Zero-based rank of the set bit
+ * @return Index of the set bit or bitset size if there is none
+ *
+ * @sa bh_bitset_rank
+ */
+size_t bh_bitset_select(const bh_bitset_t *bitset,
+                        size_t rank);
+
+/**
+ * Perform bitwise AND of two bitsets, result is stored in the first one.
+ *
+ * @param bitset  Pointer to the bitset
+ * @param other   Pointer to the other bitset of the same size
+ * @return 0 on success, non-zero if sizes are different
+ *
+ * @sa bh_bitset_or, bh_bitset_xor, bh_bitset_andnot
+ */
+int bh_bitset_and(bh_bitset_t *bitset,
+                  const bh_bitset_t *other);
+
+/**
+ * Perform bitwise OR of two bitsets, result is stored in the first one.
+ *
+ * @param bitset  Pointer to the bitset
+ * @param other   Pointer to the other bitset of the same size
+ * @return 0 on success, non-zero if sizes are different
+ *
+ * @sa bh_bitset_and, bh_bitset_xor, bh_bitset_andnot
+ */
+int bh_bitset_or(bh_bitset_t *bitset,
+                 const bh_bitset_t *other);
+
+/**
+ * Perform bitwise XOR of two bitsets, result is stored in the first one.
+ *
+ * @param bitset  Pointer to the bitset
+ * @param other   Pointer to the other bitset of the same size
+ * @return 0 on success, non-zero if sizes are different
+ *
+ * @sa bh_bitset_and, bh_bitset_or, bh_bitset_andnot
+ */
+int bh_bitset_xor(bh_bitset_t *bitset,
+                  const bh_bitset_t *other);
+
+/**
+ * Clear bits of the first bitset, that are set in the other one.
+ *
+ * @param bitset  Pointer to the bitset
+ * @param other   Pointer to the other bitset of the same size
+ * @return 0 on success, non-zero if sizes are different
+ *
+ * @sa bh_bitset_and, bh_bitset_or, bh_bitset_xor
+ */
+int bh_bitset_andnot(bh_bitset_t *bitset,
+                     const bh_bitset_t *other);
+
+/**
+ * Return amount of bits in the bitset.
+ *
+ * @param bitset  Pointer to the bitset
+ * @return Amount of bits
+ */
+#define bh_bitset_size(bitset) \
+    (bitset)->size
+
+/**
+ * Return pointer to the bitset words.
+ *
+ * @param bitset  Pointer to the bitset
+ * @return Pointer to the 64-bit words or null
+ */
+#define bh_bitset_data(bitset) \
+    (bitset)->data
+
+/**
+ * Initialize columnar container.
+ *
+ * Each column stores its values in separate contiguous buffer, while all
+ * columns share the same size and capacity. Scans over few columns touch
+ * only their buffers.
+ *
+ * Example:
+ * @code
+ * size_t element[2] = {sizeof(int), sizeof(double)};
+ * bh_columns_t table;
+ * double sum, *price;
+ * size_t i;
+ *
+ * bh_columns_init(&table, element, 2);
+ * ...
+ * price = bh_columns_data(&table, 1);
+ * for (i = 0, sum = 0.0; i < bh_columns_size(&table); i++)
+ *     sum += price[i];
+ * @endcode
+ *
+ * @param columns  Pointer to the columnar container
+ * @param element  Pointer to the element sizes of the columns
+ * @param count    Amount of columns (at most BH_COLUMNS_MAX)
+ * @return 0 on success, non-zero otherwise
+ *
+ * @sa bh_columns_init_alloc, bh_columns_destroy
+ */
+int bh_columns_init(bh_columns_t *columns,
+                    const size_t *element,
+                    size_t count);
+
+/**
+ * Initialize columnar container with the specified allocator.
+ *
+ * @param columns    Pointer to the columnar container
+ * @param element    Pointer to the element sizes of the columns
+ * @param count      Amount of columns (at most BH_COLUMNS_MAX)
+ * @param allocator  Pointer to the allocator or null (default allocator)
+ * @return 0 on success, non-zero otherwise
  *
- * @sa bh_array_clear, bh_array_remove
+ * @sa bh_columns_init, bh_columns_destroy
  */
-void bh_array_destroy(bh_array_t *array);
+int bh_columns_init_alloc(bh_columns_t *columns,
+                          const size_t *element,
+                          size_t count,
+                          const bh_allocator_t *allocator);
 
 /**
- * Reset array size counter to zero.
+ * Destroy columnar container.
  *
- * @param array  Pointer to the array
+ * @param columns  Pointer to the columnar container
  *
- * @warning If array's elements require custom destruction (by calling their
- *          respective destroy function) - then user should iterate over an
- *          array to manually destroy elements.
+ * @warning Rows are not destroyed.
+ */
+void bh_columns_destroy(bh_columns_t *columns);
+
+/**
+ * Clear columnar container.
  *
- * @sa bh_array_destroy, bh_array_remove
+ * @param columns  Pointer to the columnar container
+ *
+ * @warning Rows are not destroyed.
  */
-void bh_array_clear(bh_array_t *array);
+void bh_columns_clear(bh_columns_t *columns);
 
 /**
- * Reserve memory for the array to store required elements.
+ * Reserve memory for the columnar container to store required rows.
  *
- * @param array  Pointer to the array
- * @param size   Anticipated array size
+ * Either all columns are reallocated or none of them.
  *
+ * @param columns  Pointer to the columnar container
+ * @param size     Anticipated amount of rows
  * @return 0 on success, non-zero otherwise
  *
- * @sa bh_array_capacity, bh_array_resize
+ * @sa bh_columns_capacity, bh_columns_resize
  */
-int bh_array_reserve(bh_array_t *array,
-                     size_t size);
+int bh_columns_reserve(bh_columns_t *columns,
+                       size_t size);
 
 /**
- * Changes array's size.
+ * Set columnar container growth factor.
  *
- * In case where new size is bigger then array's capacity - bh_array_reserve
- * will be called implicitly.
+ * @param columns  Pointer to the columnar container
+ * @param growth   Growth factor in percents (should be greater than 100)
  *
- * @param array  Pointer to the array
- * @param size   New size of the array
+ * @sa bh_array_set_growth
+ */
+void bh_columns_set_growth(bh_columns_t *columns,
+                           size_t growth);
+
+/**
+ * Change amount of rows in the columnar container.
  *
+ * @param columns  Pointer to the columnar container
+ * @param size     New amount of rows
  * @return 0 on success, non-zero otherwise
  *
- * @warning In case of array growing - inserted items are not initialized.
- * @warning In case of array shrinking - removed items are not destroyed.
+ * @warning In case of growing - inserted rows are not initialized.
+ * @warning In case of shrinking - removed rows are not destroyed.
  *
- * @sa bh_array_reserve, bh_array_size
+ * @sa bh_columns_reserve, bh_columns_size
  */
-int bh_array_resize(bh_array_t *array,
-                    size_t size);
+int bh_columns_resize(bh_columns_t *columns,
+                      size_t size);
 
 /**
- * Prepare space in array for the new element at specified index.
+ * Prepare space for the new row at specified index.
  *
- * @param array  Pointer to the array
- * @param index  Index
- * @return Non-null iterator on success, null otherwise
+ * @param columns  Pointer to the columnar container
+ * @param index    Row index
+ * @return 0 on success, non-zero otherwise
  *
- * @warning If index value greater-or-equal to array size - element
- *          will be inserted at the back of an array.
+ * @warning If index value greater-or-equal to the size - row will be
+ *          inserted at the back.
  *
- * @warning Inserted element are not initialized.
+ * @warning Inserted row is not initialized.
  *
- * @sa bh_array_remove, bh_array_next, bh_array_value
+ * @sa bh_columns_insert_n, bh_columns_at, bh_columns_remove
  */
-void *bh_array_insert(bh_array_t *array,
+int bh_columns_insert(bh_columns_t *columns,
                       size_t index);
 
 /**
- * Return iterator to the specified index.
+ * Prepare space for the multiple new rows at specified index.
  *
- * @param array  Pointer to the array
- * @param index  Index
- * @return Non-null iterator on success, null otherwise
+ * @param columns  Pointer to the columnar container
+ * @param index    Row index
+ * @param count    Amount of rows
+ * @return 0 on success, non-zero otherwise
  *
- * @sa bh_array_next, bh_array_value, bh_array_remove
+ * @warning If index value greater-or-equal to the size - rows will be
+ *          inserted at the back.
+ *
+ * @warning Inserted rows are not initialized.
+ *
+ * @sa bh_columns_insert, bh_columns_erase_range
  */
-void *bh_array_at(bh_array_t *array,
-                  size_t index);
+int bh_columns_insert_n(bh_columns_t *columns,
+                        size_t index,
+                        size_t count);
 
 /**
- * Remove element by iterator.
+ * Remove row at specified index.
  *
- * All elements to the right of the element pointed by iterator
- * will be shifted left.
+ * All rows after the removed one are shifted left.
  *
- * @param array  Pointer to the array
- * @param iter   Iterator
- * @return Iterator to the next element or null if reached the end
+ * @param columns  Pointer to the columnar container
+ * @param index    Row index
  *
- * @warning Removed element are not destroyed.
+ * @warning Removed row is not destroyed.
  *
- * @sa bh_array_at, bh_array_insert, bh_array_next, bh_array_value
+ * @sa bh_columns_insert, bh_columns_erase_range
  */
-void *bh_array_remove(bh_array_t *array,
-                      void *iter);
+void bh_columns_remove(bh_columns_t *columns,
+                       size_t index);
 
 /**
- * Return iterator to the next element.
+ * Remove range of rows [first, last).
  *
- * If passed NULL-iterator, then iterator for the first element will
- * be returned.
+ * @param columns  Pointer to the columnar container
+ * @param first    Index of the first removed row
+ * @param last     Index past the last removed row
  *
- * @param array  Pointer to the array
- * @param iter   Iterator
- * @return Iterator to the next element or null if reached the end
+ * @warning Removed rows are not destroyed.
  *
- * @sa bh_array_value, bh_array_remove
+ * @sa bh_columns_remove, bh_columns_insert_n
  */
-void *bh_array_next(bh_array_t *array,
-                    void *iter);
+void bh_columns_erase_range(bh_columns_t *columns,
+                            size_t first,
+                            size_t last);
 
 /**
- * Return pointer to the array value.
+ * Return pointer to the value of the column in specified row.
  *
- * @param array  Pointer to the array
- * @param iter   Iterator
- * @return Pointer to the array value
+ * @param columns  Pointer to the columnar container
+ * @param column   Column index
+ * @param index    Row index
+ * @return Pointer to the value
  *
- * @sa bh_array_next, bh_array_remove
+ * @sa bh_columns_data
  */
-void *bh_array_value(bh_array_t *array,
-                     void *iter);
+void *bh_columns_at(bh_columns_t *columns,
+                    size_t column,
+                    size_t index);
 
 /**
- * Return array size
- *
- * @param array  Pointer to the array
- * @return Array size
+ * Return amount of rows.
  *
- * @sa bh_array_capacity
+ * @param columns  Pointer to the columnar container
+ * @return Amount of rows
  */
-#define bh_array_size(array) \
-    (array)->size
+#define bh_columns_size(columns) \
+    (columns)->size
 
 /**
- * Return array capacity.
+ * Return capacity in rows.
  *
- * @param array  Pointer to the array
- * @return Array capacity
+ * @param columns  Pointer to the columnar container
+ * @return Capacity
+ */
+#define bh_columns_capacity(columns) \
+    (columns)->capacity
+
+/**
+ * Return amount of columns.
  *
- * @sa bh_array_size
+ * @param columns  Pointer to the columnar container
+ * @return Amount of columns
  */
-#define bh_array_capacity(array) \
-    (array)->capacity
+#define bh_columns_count(columns) \
+    (columns)->count
 
 /**
- * Return pointer to the beginning of the data.
+ * Return pointer to the beginning of the column data.
  *
- * @param array  Pointer to the array
- * @return Pointer to the data or null (if array doesn't have capacity)
+ * Pointer is invalidated when the container is reallocated.
+ *
+ * @param columns  Pointer to the columnar container
+ * @param column   Column index
+ * @return Pointer to the column data or null (if there is no capacity)
  */
-#define bh_array_data(array) \
-    (array)->data
+#define bh_columns_data(columns, column) \
+    (columns)->data[column]
 
 /**
  * Initialize map with specified key and value size, comparasion and hash
@@ -249,6 +1311,27 @@ void bh_map_init(bh_map_t *map,
                  bh_compare_cb_t compare,
                  bh_hash_cb_t hash);
 
+/**
+ * Initialize map with the allocator.
+ *
+ * @param map        Pointer to the map
+ * @param key        Key size
+ * @param value      Value size
+ * @param compare    Compare function
+ * @param hash       Hash function
+ * @param allocator  Pointer to the allocator or null (default allocator)
+ *
+ * @warning Allocator should outlive the map.
+ *
+ * @sa bh_map_init, bh_allocator_default
+ */
+void bh_map_init_alloc(bh_map_t *map,
+                       size_t key,
+                       size_t value,
+                       bh_compare_cb_t compare,
+                       bh_hash_cb_t hash,
+                       const bh_allocator_t *allocator);
+
 /**
  * Destroy map.
  *
@@ -398,6 +1481,21 @@ void *bh_map_value(bh_map_t *map,
 void bh_queue_init(bh_queue_t *queue,
                    size_t element);
 
+/**
+ * Initialize queue with the allocator.
+ *
+ * @param queue      Pointer to the queue
+ * @param element    Element size
+ * @param allocator  Pointer to the allocator or null (default allocator)
+ *
+ * @warning Allocator should outlive the queue.
+ *
+ * @sa bh_queue_init, bh_allocator_default
+ */
+void bh_queue_init_alloc(bh_queue_t *queue,
+                         size_t element,
+                         const bh_allocator_t *allocator);
+
 /**
  * Destroy queue.
  *
@@ -446,6 +1544,17 @@ void bh_queue_clear(bh_queue_t *queue);
 int bh_queue_reserve(bh_queue_t *queue,
                      size_t size);
 
+/**
+ * Set queue growth factor.
+ *
+ * @param queue   Pointer to the queue
+ * @param growth  Growth factor in percents (should be greater than 100)
+ *
+ * @sa bh_array_set_growth, bh_queue_reserve
+ */
+void bh_queue_set_growth(bh_queue_t *queue,
+                         size_t growth);
+
 /**
  * Insert element at the front of the queue.
  *
@@ -547,4 +1656,300 @@ void *bh_queue_value(bh_queue_t *queue,
 #define bh_queue_capacity(queue) \
     (queue)->capacity
 
+/**
+ * Initialize top-k container with the specified element size, amount of kept
+ * elements and comparasion function.
+ *
+ * Container keeps count first elements (in terms of compare function) of all
+ * pushed elements in a bounded heap. To keep biggest elements - reverse
+ * compare function.
+ *
+ * @param topk     Pointer to the top-k container
+ * @param element  Element size
+ * @param count    Amount of kept elements
+ * @param compare  Compare function
+ *
+ * @sa bh_topk_destroy
+ */
+void bh_topk_init(bh_topk_t *topk,
+                  size_t element,
+                  size_t count,
+                  bh_compare_cb_t compare);
+
+/**
+ * Initialize top-k container with the allocator.
+ *
+ * @param topk       Pointer to the top-k container
+ * @param element    Element size
+ * @param count      Amount of kept elements
+ * @param compare    Compare function
+ * @param allocator  Pointer to the allocator or null (default allocator)
+ *
+ * @sa bh_topk_init, bh_allocator_default
+ */
+void bh_topk_init_alloc(bh_topk_t *topk,
+                        size_t element,
+                        size_t count,
+                        bh_compare_cb_t compare,
+                        const bh_allocator_t *allocator);
+
+/**
+ * Destroy top-k container.
+ *
+ * @param topk  Pointer to the top-k container
+ *
+ * @sa bh_topk_clear
+ */
+void bh_topk_destroy(bh_topk_t *topk);
+
+/**
+ * Reset top-k container size to zero.
+ *
+ * @param topk  Pointer to the top-k container
+ *
+ * @sa bh_topk_destroy
+ */
+void bh_topk_clear(bh_topk_t *topk);
+
+/**
+ * Push element into the top-k container.
+ *
+ * Element is copied into the container if it is among first count elements,
+ * otherwise it is discarded.
+ *
+ * @param topk  Pointer to the top-k container
+ * @param item  Pointer to the item
+ * @return 0 on success, non-zero otherwise
+ *
+ * @sa bh_topk_push_n, bh_topk_sort
+ */
+int bh_topk_push(bh_topk_t *topk,
+                 const void *item);
+
+/**
+ * Push multiple elements into the top-k container.
+ *
+ * @param topk   Pointer to the top-k container
+ * @param items  Pointer to the items
+ * @param count  Amount of items
+ * @return 0 on success, non-zero otherwise
+ *
+ * @sa bh_topk_push, bh_topk_sort
+ */
+int bh_topk_push_n(bh_topk_t *topk,
+                   const void *items,
+                   size_t count);
+
+/**
+ * Return pointer to the worst kept element.
+ *
+ * @param topk  Pointer to the top-k container
+ * @return Pointer to the element or null if container is empty
+ */
+void *bh_topk_top(bh_topk_t *topk);
+
+/**
+ * Sort kept elements.
+ *
+ * After sorting elements can be accessed in order with bh_topk_data. Pushing
+ * new elements is still allowed.
+ *
+ * @param topk  Pointer to the top-k container
+ *
+ * @sa bh_topk_data, bh_topk_size
+ */
+void bh_topk_sort(bh_topk_t *topk);
+
+/**
+ * Return amount of kept elements.
+ *
+ * @param topk  Pointer to the top-k container
+ * @return Amount of kept elements
+ */
+#define bh_topk_size(topk) \
+    (topk)->size
+
+/**
+ * Return pointer to the kept elements.
+ *
+ * @param topk  Pointer to the top-k container
+ * @return Pointer to the data or null
+ *
+ * @sa bh_topk_sort
+ */
+#define bh_topk_data(topk) \
+    (topk)->data
+
+/**
+ * Initialize priority queue with the specified element size, arity and
+ * comparasion function.
+ *
+ * Priority queue is implemented as d-ary heap, where top element is the
+ * biggest element (in terms of compare function). Bigger arity makes heap
+ * shallower, so fewer elements are moved on insertion and children of each
+ * element share cache lines.
+ *
+ * @param queue    Pointer to the priority queue
+ * @param element  Element size
+ * @param arity    Heap arity (0 for default BH_PQUEUE_ARITY)
+ * @param compare  Compare function
+ *
+ * @sa bh_pqueue_destroy
+ */
+void bh_pqueue_init(bh_pqueue_t *queue,
+                    size_t element,
+                    size_t arity,
+                    bh_compare_cb_t compare);
+
+/**
+ * Initialize priority queue with the allocator.
+ *
+ * @param queue      Pointer to the priority queue
+ * @param element    Element size
+ * @param arity      Heap arity (0 for default BH_PQUEUE_ARITY)
+ * @param compare    Compare function
+ * @param allocator  Pointer to the allocator or null (default allocator)
+ *
+ * @sa bh_pqueue_init, bh_allocator_default
+ */
+void bh_pqueue_init_alloc(bh_pqueue_t *queue,
+                          size_t element,
+                          size_t arity,
+                          bh_compare_cb_t compare,
+                          const bh_allocator_t *allocator);
+
+/**
+ * Destroy priority queue.
+ *
+ * @param queue  Pointer to the priority queue
+ *
+ * @warning If queue's elements require custom destruction (by calling their
+ *          respective destroy function) - then user should iterate over a
+ *          queue to manually destroy elements.
+ *
+ * @sa bh_pqueue_clear
+ */
+void bh_pqueue_destroy(bh_pqueue_t *queue);
+
+/**
+ * Reset priority queue size to zero.
+ *
+ * @param queue  Pointer to the priority queue
+ *
+ * @sa bh_pqueue_destroy
+ */
+void bh_pqueue_clear(bh_pqueue_t *queue);
+
+/**
+ * Reserve memory for the priority queue to store required elements.
+ *
+ * @param queue  Pointer to the priority queue
+ * @param size   Anticipated queue size
+ * @return 0 on success, non-zero otherwise
+ *
+ * @sa bh_pqueue_capacity
+ */
+int bh_pqueue_reserve(bh_pqueue_t *queue,
+                      size_t size);
+
+/**
+ * Set priority queue growth factor.
+ *
+ * @param queue   Pointer to the priority queue
+ * @param growth  Growth factor in percents (should be greater than 100)
+ *
+ * @sa bh_array_set_growth, bh_pqueue_reserve
+ */
+void bh_pqueue_set_growth(bh_pqueue_t *queue,
+                          size_t growth);
+
+/**
+ * Insert element into the priority queue.
+ *
+ * @param queue  Pointer to the priority queue
+ * @param item   Pointer to the item
+ * @return 0 on success, non-zero otherwise
+ *
+ * @sa bh_pqueue_push_n, bh_pqueue_pop, bh_pqueue_top
+ */
+int bh_pqueue_push(bh_pqueue_t *queue,
+                   const void *item);
+
+/**
+ * Insert multiple elements into the priority queue.
+ *
+ * If amount of inserted elements is comparable to the queue size, elements
+ * are appended and the heap is rebuilt in linear time.
+ *
+ * @param queue  Pointer to the priority queue
+ * @param items  Pointer to the items
+ * @param count  Amount of items
+ * @return 0 on success, non-zero otherwise
+ *
+ * @sa bh_pqueue_push
+ */
+int bh_pqueue_push_n(bh_pqueue_t *queue,
+                     const void *items,
+                     size_t count);
+
+/**
+ * Return pointer to the top element of the priority queue.
+ *
+ * @param queue  Pointer to the priority queue
+ * @return Pointer to the top element or null if queue is empty
+ *
+ * @sa bh_pqueue_pop, bh_pqueue_replace_top
+ */
+void *bh_pqueue_top(bh_pqueue_t *queue);
+
+/**
+ * Remove top element from the priority queue.
+ *
+ * @param queue  Pointer to the priority queue
+ *
+ * @warning Removed element is not destroyed.
+ *
+ * @sa bh_pqueue_top, bh_pqueue_push
+ */
+void bh_pqueue_pop(bh_pqueue_t *queue);
+
+/**
+ * Replace top element of the priority queue.
+ *
+ * Equivalent to bh_pqueue_pop followed by bh_pqueue_push, but requires only
+ * one sift. If queue is empty, element is inserted.
+ *
+ * @param queue  Pointer to the priority queue
+ * @param item   Pointer to the item
+ * @return 0 on success, non-zero otherwise
+ *
+ * @warning Replaced element is not destroyed.
+ *
+ * @sa bh_pqueue_top, bh_pqueue_pop
+ */
+int bh_pqueue_replace_top(bh_pqueue_t *queue,
+                          const void *item);
+
+/**
+ * Return priority queue size.
+ *
+ * @param queue  Pointer to the priority queue
+ * @return Priority queue size
+ *
+ * @sa bh_pqueue_capacity
+ */
+#define bh_pqueue_size(queue) \
+    (queue)->size
+
+/**
+ * Return priority queue capacity.
+ *
+ * @param queue  Pointer to the priority queue
+ * @return Priority queue capacity
+ *
+ * @sa bh_pqueue_size
+ */
+#define bh_pqueue_capacity(queue) \
+    (queue)->capacity
+
 #endif /* BHLIB_DS_H */
@@ -0,0 +1,192 @@
+/*
+ * BHLib
+ *
+ * Copyright (c) 2024 Mikhail Romanko
+ */
+
+/**
+ * @file bh/hash.h
+ */
+
+#ifndef BHLIB_HASH_H
+#define BHLIB_HASH_H
+
+#include "bh.h"
+#include <stddef.h>
+
+#define BH_HASH_SEED 0
+
+/**
+ * Calculate hash of the bytes.
+ *
+ * Hash is based on the wyhash algorithm: input is mixed with 64x64 to 128-bit
+ * multiplications, which gives good avalanche properties in all bits of the
+ * result (including lower bits, used by bh_map_t to select buckets) at memory
+ * bandwidth speed.
+ *
+ * Hash values don't depend on platform endianness.
+ *
+ * @param data  Pointer to the data
+ * @param size  Data size
+ * @param seed  Seed value
+ * @return Hash value
+ *
+ * @sa bh_hash_string, bh_hash4, bh_hash8, bh_hash16
+ */
+size_t bh_hash_bytes(const void *data,
+                     size_t size,
+                     size_t seed);
+
+/**
+ * Calculate hash of the null-terminated string.
+ *
+ * Result is the same as bh_hash_bytes of the string without terminator.
+ *
+ * @param str   Pointer to the string
+ * @param seed  Seed value
+ * @return Hash value
+ *
+ * @sa bh_hash_bytes
+ */
+size_t bh_hash_string(const char *str,
+                      size_t seed);
+
+/**
+ * Calculate hash of the 4-byte key.
+ *
+ * Result is the same as bh_hash_bytes with the size of 4.
+ *
+ * @param key   Pointer to the key
+ * @param seed  Seed value
+ * @return Hash value
+ *
+ * @sa bh_hash_bytes, bh_hash8, bh_hash16
+ */
+size_t bh_hash4(const void *key,
+                size_t seed);
+
+/**
+ * Calculate hash of the 8-byte key.
+ *
+ * Result is the same as bh_hash_bytes with the size of 8.
+ *
+ * @param key   Pointer to the key
+ * @param seed  Seed value
+ * @return Hash value
+ *
+ * @sa bh_hash_bytes, bh_hash4, bh_hash16
+ */
+size_t bh_hash8(const void *key,
+                size_t seed);
+
+/**
+ * Calculate hash of the 16-byte key.
+ *
+ * Result is the same as bh_hash_bytes with the size of 16.
+ *
+ * @param key   Pointer to the key
+ * @param seed  Seed value
+ * @return Hash value
+ *
+ * @sa bh_hash_bytes, bh_hash4, bh_hash8
+ */
+size_t bh_hash16(const void *key,
+                 size_t seed);
+
+/**
+ * Hash function for 4-byte keys (such as int or float).
+ *
+ * Uses default seed (BH_HASH_SEED). Pairs with bh_compare_key4.
+ *
+ * @param key  Pointer to the key
+ * @return Hash value
+ *
+ * @sa bh_map_init, bh_compare_key4
+ */
+size_t bh_hash_key4(const void *key);
+
+/**
+ * Hash function for 8-byte keys (such as 64-bit integers or pointers).
+ *
+ * Uses default seed (BH_HASH_SEED). Pairs with bh_compare_key8.
+ *
+ * @param key  Pointer to the key
+ * @return Hash value
+ *
+ * @sa bh_map_init, bh_compare_key8
+ */
+size_t bh_hash_key8(const void *key);
+
+/**
+ * Hash function for 16-byte keys.
+ *
+ * Uses default seed (BH_HASH_SEED). Pairs with bh_compare_key16.
+ *
+ * @param key  Pointer to the key
+ * @return Hash value
+ *
+ * @sa bh_map_init, bh_compare_key16
+ */
+size_t bh_hash_key16(const void *key);
+
+/**
+ * Hash function for string keys (key is a pointer to the string).
+ *
+ * Uses default seed (BH_HASH_SEED). Pairs with bh_compare_key_string.
+ *
+ * @param key  Pointer to the pointer to the string
+ * @return Hash value
+ *
+ * @sa bh_map_init, bh_compare_key_string
+ */
+size_t bh_hash_key_string(const void *key);
+
+/**
+ * Compare 4-byte keys as unsigned integers.
+ *
+ * @param a  Pointer to the first key
+ * @param b  Pointer to the second key
+ * @return Negative, zero or positive value
+ *
+ * @sa bh_hash_key4
+ */
+int bh_compare_key4(const void *a,
+                    const void *b);
+
+/**
+ * Compare 8-byte keys as unsigned integers.
+ *
+ * @param a  Pointer to the first key
+ * @param b  Pointer to the second key
+ * @return Negative, zero or positive value
+ *
+ * @sa bh_hash_key8
+ */
+int bh_compare_key8(const void *a,
+                    const void *b);
+
+/**
+ * Compare 16-byte keys bytewise.
+ *
+ * @param a  Pointer to the first key
+ * @param b  Pointer to the second key
+ * @return Negative, zero or positive value
+ *
+ * @sa bh_hash_key16
+ */
+int bh_compare_key16(const void *a,
+                     const void *b);
+
+/**
+ * Compare string keys (keys are pointers to the strings).
+ *
+ * @param a  Pointer to the pointer to the first string
+ * @param b  Pointer to the pointer to the second string
+ * @return Negative, zero or positive value
+ *
+ * @sa bh_hash_key_string
+ */
+int bh_compare_key_string(const void *a,
+                          const void *b);
+
+#endif /* BHLIB_HASH_H */
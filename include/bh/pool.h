@@ -0,0 +1,189 @@
+/*
+ * BHLib
+ *
+ * Copyright (c) 2024 Mikhail Romanko
+ */
+
+/**
+ * @file bh/pool.h
+ */
+
+#ifndef BHLIB_POOL_H
+#define BHLIB_POOL_H
+
+#include "bh.h"
+#include "alloc.h"
+#include "thread.h"
+#include <stddef.h>
+
+#define BH_POOL_BLOCK   65536
+#define BH_POOL_CACHE   32
+
+typedef struct bh_pool_block_s
+{
+    struct bh_pool_block_s *next;
+    size_t size;
+} bh_pool_block_t;
+
+typedef struct bh_pool_s
+{
+    void *free;
+    char *current;
+    char *end;
+    bh_pool_block_t *blocks;
+    size_t size;
+    size_t block_size;
+    size_t count;
+    const bh_allocator_t *backing;
+    bh_allocator_t allocator;
+    bh_mutex_t mutex;
+    int shared;
+} bh_pool_t;
+
+typedef struct
+{
+    bh_pool_t *pool;
+    void *free;
+    size_t size;
+} bh_pool_cache_t;
+
+/**
+ * Initialize pool of fixed size objects.
+ *
+ * Objects are carved from large blocks (allocated lazily with the backing
+ * allocator) and recycled through the intrusive free list. Objects are
+ * aligned to the pointer size.
+ *
+ * Initialized pool is not thread-safe, see bh_pool_init_shared.
+ *
+ * @param pool        Pointer to the pool
+ * @param size        Object size
+ * @param block_size  Block size in bytes (0 for default BH_POOL_BLOCK)
+ * @param backing     Pointer to the backing allocator or null (default)
+ *
+ * @sa bh_pool_destroy, bh_pool_alloc, bh_pool_free
+ */
+void bh_pool_init(bh_pool_t *pool,
+                  size_t size,
+                  size_t block_size,
+                  const bh_allocator_t *backing);
+
+/**
+ * Initialize thread-safe pool of fixed size objects.
+ *
+ * Pool operations are protected by the mutex. Threads, that allocate and
+ * free a lot of objects, should use per-thread caches (bh_pool_cache_t),
+ * which access the pool in batches of BH_POOL_CACHE objects.
+ *
+ * @param pool        Pointer to the pool
+ * @param size        Object size
+ * @param block_size  Block size in bytes (0 for default BH_POOL_BLOCK)
+ * @param backing     Pointer to the backing allocator or null (default)
+ * @return 0 on success, non-zero otherwise
+ *
+ * @sa bh_pool_init, bh_pool_cache_init
+ */
+int bh_pool_init_shared(bh_pool_t *pool,
+                        size_t size,
+                        size_t block_size,
+                        const bh_allocator_t *backing);
+
+/**
+ * Destroy pool.
+ *
+ * All blocks are freed, including objects that were not returned.
+ *
+ * @param pool  Pointer to the pool
+ */
+void bh_pool_destroy(bh_pool_t *pool);
+
+/**
+ * Allocate object from the pool.
+ *
+ * @param pool  Pointer to the pool
+ * @return Pointer to the object or null
+ *
+ * @sa bh_pool_free
+ */
+void *bh_pool_alloc(bh_pool_t *pool);
+
+/**
+ * Return object to the pool.
+ *
+ * @param pool  Pointer to the pool
+ * @param ptr   Pointer to the object or null
+ *
+ * @sa bh_pool_alloc
+ */
+void bh_pool_free(bh_pool_t *pool,
+                  void *ptr);
+
+/**
+ * Return allocator interface of the pool.
+ *
+ * Requests, that fit into the pool object, are served from the pool, larger
+ * requests are forwarded to the backing allocator (sizes passed to the free
+ * callback are used to route deallocations).
+ *
+ * @param pool  Pointer to the pool
+ * @return Pointer to the allocator
+ *
+ * @warning Pool can't be moved after this function was called.
+ */
+const bh_allocator_t *bh_pool_allocator(bh_pool_t *pool);
+
+/**
+ * Return amount of allocated objects.
+ *
+ * @param pool  Pointer to the pool
+ * @return Amount of objects
+ */
+#define bh_pool_count(pool) \
+    (pool)->count
+
+/**
+ * Initialize per-thread cache of the pool.
+ *
+ * Cache keeps local free list of objects and is used by a single thread
+ * without locking. Objects are taken from and returned to the pool in
+ * batches.
+ *
+ * @param cache  Pointer to the cache
+ * @param pool   Pointer to the pool
+ *
+ * @sa bh_pool_cache_destroy, bh_pool_cache_alloc, bh_pool_cache_free
+ */
+void bh_pool_cache_init(bh_pool_cache_t *cache,
+                        bh_pool_t *pool);
+
+/**
+ * Destroy cache, returning cached objects to the pool.
+ *
+ * @param cache  Pointer to the cache
+ */
+void bh_pool_cache_destroy(bh_pool_cache_t *cache);
+
+/**
+ * Allocate object through the cache.
+ *
+ * @param cache  Pointer to the cache
+ * @return Pointer to the object or null
+ *
+ * @sa bh_pool_cache_free
+ */
+void *bh_pool_cache_alloc(bh_pool_cache_t *cache);
+
+/**
+ * Return object through the cache.
+ *
+ * Object can be allocated by any cache of the same pool.
+ *
+ * @param cache  Pointer to the cache
+ * @param ptr    Pointer to the object or null
+ *
+ * @sa bh_pool_cache_alloc
+ */
+void bh_pool_cache_free(bh_pool_cache_t *cache,
+                        void *ptr);
+
+#endif /* BHLIB_POOL_H */
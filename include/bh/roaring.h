@@ -0,0 +1,204 @@
+/*
+ * BHLib
+ *
+ * Copyright (c) 2024 Mikhail Romanko
+ */
+
+/**
+ * @file bh/roaring.h
+ */
+
+#ifndef BHLIB_ROARING_H
+#define BHLIB_ROARING_H
+
+#include "bh.h"
+#include "ds.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#define BH_ROARING_ARRAY_MAX 4096
+
+typedef struct
+{
+    bh_array_t chunks;
+} bh_roaring_t;
+
+/**
+ * Initialize compressed bitmap of 32-bit integers.
+ *
+ * Values are split into chunks by upper 16 bits. Each chunk stores lower
+ * 16 bits in one of the containers:
+ *  - sorted array, if chunk has up to BH_ROARING_ARRAY_MAX values;
+ *  - bitmap of 65536 bits, if chunk has more values;
+ *  - sorted list of runs, if it's smaller (see bh_roaring_optimize).
+ *
+ * @param roaring  Pointer to the bitmap
+ *
+ * @sa bh_roaring_init_alloc, bh_roaring_destroy
+ */
+void bh_roaring_init(bh_roaring_t *roaring);
+
+/**
+ * Initialize compressed bitmap with the specified allocator.
+ *
+ * @param roaring    Pointer to the bitmap
+ * @param allocator  Pointer to the allocator or null (default allocator)
+ *
+ * @sa bh_roaring_init, bh_roaring_destroy
+ */
+void bh_roaring_init_alloc(bh_roaring_t *roaring,
+                           const bh_allocator_t *allocator);
+
+/**
+ * Destroy compressed bitmap.
+ *
+ * @param roaring  Pointer to the bitmap
+ */
+void bh_roaring_destroy(bh_roaring_t *roaring);
+
+/**
+ * Remove all values from the compressed bitmap.
+ *
+ * @param roaring  Pointer to the bitmap
+ */
+void bh_roaring_clear(bh_roaring_t *roaring);
+
+/**
+ * Add value to the compressed bitmap.
+ *
+ * @param roaring  Pointer to the bitmap
+ * @param value    Value
+ * @return 0 on success, non-zero otherwise
+ *
+ * @sa bh_roaring_remove, bh_roaring_contains
+ */
+int bh_roaring_add(bh_roaring_t *roaring,
+                   uint32_t value);
+
+/**
+ * Remove value from the compressed bitmap.
+ *
+ * @param roaring  Pointer to the bitmap
+ * @param value    Value
+ * @return 0 on success, non-zero otherwise
+ *
+ * @sa bh_roaring_add, bh_roaring_contains
+ */
+int bh_roaring_remove(bh_roaring_t *roaring,
+                      uint32_t value);
+
+/**
+ * Check if the compressed bitmap contains value.
+ *
+ * @param roaring  Pointer to the bitmap
+ * @param value    Value
+ * @return 1 if value is present, 0 otherwise
+ *
+ * @sa bh_roaring_add, bh_roaring_remove
+ */
+int bh_roaring_contains(const bh_roaring_t *roaring,
+                        uint32_t value);
+
+/**
+ * Return amount of values in the compressed bitmap.
+ *
+ * @param roaring  Pointer to the bitmap
+ * @return Amount of values
+ */
+size_t bh_roaring_count(const bh_roaring_t *roaring);
+
+/**
+ * Convert chunks to run containers, where it saves memory.
+ *
+ * @param roaring  Pointer to the bitmap
+ * @return 0 on success, non-zero otherwise
+ */
+int bh_roaring_optimize(bh_roaring_t *roaring);
+
+/**
+ * Copy values of the compressed bitmap in ascending order.
+ *
+ * @param roaring  Pointer to the bitmap
+ * @param out      Pointer to the output (should fit bh_roaring_count values)
+ * @return Amount of copied values
+ */
+size_t bh_roaring_to_array(const bh_roaring_t *roaring,
+                           uint32_t *out);
+
+/**
+ * Calculate intersection of two compressed bitmaps.
+ *
+ * Previous content of the output is replaced. Output can be the same
+ * bitmap as one of the inputs.
+ *
+ * @param out  Pointer to the output bitmap
+ * @param a    Pointer to the first bitmap
+ * @param b    Pointer to the second bitmap
+ * @return 0 on success, non-zero otherwise
+ *
+ * @sa bh_roaring_or
+ */
+int bh_roaring_and(bh_roaring_t *out,
+                   const bh_roaring_t *a,
+                   const bh_roaring_t *b);
+
+/**
+ * Calculate union of two compressed bitmaps.
+ *
+ * Previous content of the output is replaced. Output can be the same
+ * bitmap as one of the inputs.
+ *
+ * @param out  Pointer to the output bitmap
+ * @param a    Pointer to the first bitmap
+ * @param b    Pointer to the second bitmap
+ * @return 0 on success, non-zero otherwise
+ *
+ * @sa bh_roaring_and
+ */
+int bh_roaring_or(bh_roaring_t *out,
+                  const bh_roaring_t *a,
+                  const bh_roaring_t *b);
+
+/**
+ * Return size of the serialized compressed bitmap.
+ *
+ * @param roaring  Pointer to the bitmap
+ * @return Size in bytes
+ *
+ * @sa bh_roaring_serialize
+ */
+size_t bh_roaring_serialized_size(const bh_roaring_t *roaring);
+
+/**
+ * Serialize compressed bitmap into flat buffer.
+ *
+ * Format is little-endian regardless of the platform: amount of chunks
+ * (32 bits), followed by chunks. Each chunk has key (16 bits), container
+ * type (16 bits), amount of values or runs (32 bits) and container data.
+ *
+ * @param roaring  Pointer to the bitmap
+ * @param buffer   Pointer to the buffer (bh_roaring_serialized_size bytes)
+ * @return Amount of written bytes
+ *
+ * @sa bh_roaring_deserialize
+ */
+size_t bh_roaring_serialize(const bh_roaring_t *roaring,
+                            void *buffer);
+
+/**
+ * Deserialize compressed bitmap from flat buffer.
+ *
+ * Previous content of the bitmap is replaced.
+ *
+ * @param roaring  Pointer to the bitmap
+ * @param buffer   Pointer to the buffer
+ * @param size     Buffer size
+ * @return 0 on success, non-zero otherwise (including malformed buffer)
+ *
+ * @sa bh_roaring_serialize
+ */
+int bh_roaring_deserialize(bh_roaring_t *roaring,
+                           const void *buffer,
+                           size_t size);
+
+#endif /* BHLIB_ROARING_H */
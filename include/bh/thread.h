@@ -2,9 +2,15 @@
 #define BH_THREAD_H
 
 #include <bh/bh.h>
+#include <bh/ds.h>
 
 typedef void (*bh_thread_cb_t)(void *);
-typedef struct bh_tpool_s bh_tpool_t;
+
+typedef struct bh_tpool_job_s
+{
+    bh_thread_cb_t func;
+    void *data;
+} bh_tpool_job_t;
 
 #ifdef BH_USE_THREADS
 /* Include thread implementation details */
@@ -62,6 +68,9 @@ struct bh_tpool_s
     bh_queue_t jobs;
     bh_mutex_t mutex;
     bh_cond_t condition;
+    bh_cond_t done;
+    size_t active;
+    int shutdown;
 };
 
 /**
@@ -225,9 +234,20 @@ int bh_tpool_job(bh_tpool_t *pool,
  */
 int bh_tpool_join(bh_tpool_t *pool);
 
+/**
+ * Return amount of threads in the thread pool.
+ *
+ * @param pool  Pointer to the thread pool
+ * @return Amount of threads
+ */
+#define bh_tpool_size(pool) \
+    bh_array_size(&(pool)->threads)
+
 /**
  * Destroy thread pool.
  *
+ * Pending jobs are finished before threads are stopped.
+ *
  * @param pool  Pointer to the thread pool
  */
 void bh_tpool_destroy(bh_tpool_t *pool);
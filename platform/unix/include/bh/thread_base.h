@@ -32,4 +32,6 @@ int bh_thread_init(bh_thread_t *thread,
 int bh_tpool_init(bh_tpool_t *pool,
                   size_t size);
 
+void bh_tpool_worker(void *data);
+
 #endif /* BH_THREAD_BASE_H */
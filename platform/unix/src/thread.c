@@ -99,5 +99,51 @@ void bh_cond_destroy(bh_cond_t *cond)
 int bh_tpool_init(bh_tpool_t *pool,
                   size_t size)
 {
-    return -1;
+    bh_thread_t *thread;
+    size_t i;
+
+    bh_array_init(&pool->threads, sizeof(bh_thread_t));
+    bh_queue_init(&pool->jobs, sizeof(bh_tpool_job_t));
+    pool->active = 0;
+    pool->shutdown = 0;
+
+    /* Reserve space for threads, so thread pointers stay valid */
+    if (bh_array_reserve(&pool->threads, size))
+        return -1;
+
+    /* Initialize synchronization primitives */
+    if (bh_mutex_init(&pool->mutex))
+    {
+        bh_array_destroy(&pool->threads);
+        return -1;
+    }
+
+    if (bh_cond_init(&pool->condition))
+    {
+        bh_mutex_destroy(&pool->mutex);
+        bh_array_destroy(&pool->threads);
+        return -1;
+    }
+
+    if (bh_cond_init(&pool->done))
+    {
+        bh_cond_destroy(&pool->condition);
+        bh_mutex_destroy(&pool->mutex);
+        bh_array_destroy(&pool->threads);
+        return -1;
+    }
+
+    /* Start worker threads */
+    for (i = 0; i < size; i++)
+    {
+        thread = bh_array_insert(&pool->threads, i);
+        if (bh_thread_init(thread, bh_tpool_worker, pool))
+        {
+            bh_array_resize(&pool->threads, i);
+            bh_tpool_destroy(pool);
+            return -1;
+        }
+    }
+
+    return 0;
 }
@@ -44,6 +44,8 @@ int bh_tpool_init_base(bh_tpool_t *pool,
                        bh_thread_win_begin_cb_t begin,
                        bh_thread_win_end_cb_t end);
 
+void bh_tpool_worker(void *data);
+
 #define bh_thread_init(thread, func, data) \
     bh_thread_init_base((thread), (func), (data), _beginthreadex, _endthreadex)
 
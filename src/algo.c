@@ -4,121 +4,532 @@
  * Copyright (c) 2024 Mikhail Romanko
  */
 #include <bh/algo.h>
+#include <bh/thread.h>
 #include <string.h>
+#include <stdlib.h>
 #include <stdio.h>
+#include <stdint.h>
+
+#if defined(__GNUC__)
+#define BH_PREFETCH(address) __builtin_prefetch(address)
+#else
+#define BH_PREFETCH(address) ((void)(address))
+#endif
+
+#define BH_SORT_INSERT_THRESHOLD    16
+#define BH_SORT_NINTHER_THRESHOLD   128
+#define BH_SORT_PARTIAL_LIMIT       8
+#define BH_SORT_MIN_GALLOP          7
+#define BH_SORT_MAX_RUNS            128
+#define BH_SORT_PARALLEL_THRESHOLD  8192
+#define BH_RADIX_INSERT_THRESHOLD   32
+#define BH_RADIX_LSD_WIDTH          8
+
+typedef struct
+{
+    char *start;
+    size_t size;
+} bh_sort_run_t;
+
+typedef struct
+{
+    char *left;
+    char *right;
+    char *to;
+    size_t left_size;
+    size_t right_size;
+    size_t element;
+    bh_compare_cb_t compare;
+} bh_sort_task_t;
+
+typedef struct
+{
+    size_t element;
+    bh_swap_cb_t swap;
+    size_t offset;
+    size_t width;
+    int flags;
+    int little;
+} bh_radix_t;
+
+typedef struct
+{
+    size_t element;
+    bh_swap_cb_t swap;
+    bh_compare_cb_t compare;
+    char *scratch;
+    bh_sort_run_t runs[BH_SORT_MAX_RUNS];
+    size_t count;
+} bh_sort_state_t;
+
+static void bh_swap1(void *a,
+                     void *b,
+                     size_t size)
+{
+    unsigned char tmp;
+
+    (void)size;
+    tmp = *(unsigned char *)a;
+    *(unsigned char *)a = *(unsigned char *)b;
+    *(unsigned char *)b = tmp;
+}
+
+static void bh_swap2(void *a,
+                     void *b,
+                     size_t size)
+{
+    uint16_t tmp1, tmp2;
+
+    (void)size;
+    memcpy(&tmp1, a, sizeof(tmp1));
+    memcpy(&tmp2, b, sizeof(tmp2));
+    memcpy(a, &tmp2, sizeof(tmp2));
+    memcpy(b, &tmp1, sizeof(tmp1));
+}
+
+static void bh_swap4(void *a,
+                     void *b,
+                     size_t size)
+{
+    uint32_t tmp1, tmp2;
+
+    (void)size;
+    memcpy(&tmp1, a, sizeof(tmp1));
+    memcpy(&tmp2, b, sizeof(tmp2));
+    memcpy(a, &tmp2, sizeof(tmp2));
+    memcpy(b, &tmp1, sizeof(tmp1));
+}
+
+static void bh_swap8(void *a,
+                     void *b,
+                     size_t size)
+{
+    uint64_t tmp1, tmp2;
+
+    (void)size;
+    memcpy(&tmp1, a, sizeof(tmp1));
+    memcpy(&tmp2, b, sizeof(tmp2));
+    memcpy(a, &tmp2, sizeof(tmp2));
+    memcpy(b, &tmp1, sizeof(tmp1));
+}
+
+static void bh_swap16(void *a,
+                      void *b,
+                      size_t size)
+{
+    unsigned char tmp1[16], tmp2[16];
+
+    /* Fixed size copies are compiled into 16-byte vector moves */
+    (void)size;
+    memcpy(tmp1, a, sizeof(tmp1));
+    memcpy(tmp2, b, sizeof(tmp2));
+    memcpy(a, tmp2, sizeof(tmp2));
+    memcpy(b, tmp1, sizeof(tmp1));
+}
+
+static void bh_swap_block(void *a,
+                          void *b,
+                          size_t size)
+{
+    unsigned char tmp1[32], tmp2[32];
+    char *left, *right;
+
+    left = (char *)a;
+    right = (char *)b;
+
+    /* Swap values in 32-byte blocks (vector registers) */
+    while (size >= sizeof(tmp1))
+    {
+        memcpy(tmp1, left, sizeof(tmp1));
+        memcpy(tmp2, right, sizeof(tmp2));
+        memcpy(left, tmp2, sizeof(tmp2));
+        memcpy(right, tmp1, sizeof(tmp1));
+
+        left += sizeof(tmp1);
+        right += sizeof(tmp1);
+        size -= sizeof(tmp1);
+    }
+
+    /* Swap the rest with smaller chunks */
+    if (size >= 16)
+    {
+        bh_swap16(left, right, 16);
+        left += 16;
+        right += 16;
+        size -= 16;
+    }
+
+    if (size >= 8)
+    {
+        bh_swap8(left, right, 8);
+        left += 8;
+        right += 8;
+        size -= 8;
+    }
+
+    if (size >= 4)
+    {
+        bh_swap4(left, right, 4);
+        left += 4;
+        right += 4;
+        size -= 4;
+    }
+
+    while (size--)
+        bh_swap1(left++, right++, 1);
+}
+
+bh_swap_cb_t bh_swap_func(size_t size)
+{
+    /* Select specialized swap function for the element size */
+    switch (size)
+    {
+    case 1: return bh_swap1;
+    case 2: return bh_swap2;
+    case 4: return bh_swap4;
+    case 8: return bh_swap8;
+    case 16: return bh_swap16;
+    default: return bh_swap_block;
+    }
+}
 
 void bh_swap(void *a,
              void *b,
              size_t size)
 {
-    int tmp;
+    bh_swap_func(size)(a, b, size);
+}
 
-    /* Swap values in int sized chunks */
-    while (size >= sizeof(tmp))
-    {
-        memmove(&tmp, a, sizeof(tmp));
-        memmove(a, b, sizeof(tmp));
-        memmove(b, &tmp, sizeof(tmp));
+static void bh_sort_insert(char *start,
+                           char *end,
+                           size_t element,
+                           bh_swap_cb_t swap,
+                           bh_compare_cb_t compare)
+{
+    char *i, *j;
 
-        a = (char *)a + sizeof(tmp);
-        b = (char *)b + sizeof(tmp);
-        size -= sizeof(tmp);
+    /* Classic insertion sort (swap based) */
+    for (i = start + element; i < end; i += element)
+    {
+        for (j = i; j > start && compare(j, j - element) < 0; j -= element)
+            swap(j, j - element, element);
     }
+}
+
+static int bh_sort_insert_partial(char *start,
+                                  char *end,
+                                  size_t element,
+                                  bh_swap_cb_t swap,
+                                  bh_compare_cb_t compare)
+{
+    char *i, *j;
+    size_t moves;
 
-    /* Swap the rest */
-    if (size)
+    /* Insertion sort that gives up after too many element moves */
+    moves = 0;
+    for (i = start + element; i < end; i += element)
     {
-        memmove(&tmp, a, size);
-        memmove(a, b, size);
-        memmove(b, &tmp, size);
+        for (j = i; j > start && compare(j, j - element) < 0; j -= element)
+        {
+            swap(j, j - element, element);
+            moves++;
+        }
+
+        if (moves > BH_SORT_PARTIAL_LIMIT)
+            return 0;
     }
+
+    return 1;
 }
 
-void bh_sort(void *array,
-             size_t element,
-             size_t size,
-             bh_compare_cb_t compare)
+static void bh_sort_heap(char *start,
+                         size_t element,
+                         size_t size,
+                         bh_compare_cb_t compare)
 {
-    bh_heap_make(array, element, size, compare);
+    bh_heap_make(start, element, size, compare);
     while (size)
-        bh_heap_pop(array, element, size--, compare);
+        bh_heap_pop(start, element, size--, compare);
 }
 
-void bh_heap_make(void *array,
-                  size_t element,
-                  size_t size,
-                  bh_compare_cb_t compare)
+static void bh_sort_reverse(char *start,
+                            char *end,
+                            size_t element,
+                            bh_swap_cb_t swap)
 {
-    char *start, *end;
-    size_t i;
+    /* Reverse elements in the range */
+    for (end -= element; start < end; start += element, end -= element)
+        swap(start, end, element);
+}
 
-    /* Calculate start and end pointers of the array */
-    start = (char *)array;
-    end = start + size * element;
+static void bh_sort3(char *a,
+                     char *b,
+                     char *c,
+                     size_t element,
+                     bh_swap_cb_t swap,
+                     bh_compare_cb_t compare)
+{
+    /* Order three elements, so the median is placed at b */
+    if (compare(b, a) < 0)
+        swap(a, b, element);
+    if (compare(c, b) < 0)
+    {
+        swap(b, c, element);
+        if (compare(b, a) < 0)
+            swap(a, b, element);
+    }
+}
 
-    /* Bottom up heapify algorithm */
-    for (i = size / 2 + 1; i; --i)
+static void bh_sort_pivot(char *start,
+                          size_t size,
+                          size_t element,
+                          bh_swap_cb_t swap,
+                          bh_compare_cb_t compare)
+{
+    char *middle, *last;
+    size_t step;
+
+    middle = start + (size / 2) * element;
+    last = start + (size - 1) * element;
+
+    /* Use Tukey's ninther for large ranges and median of 3 otherwise */
+    if (size > BH_SORT_NINTHER_THRESHOLD)
+    {
+        step = (size / 8) * element;
+        bh_sort3(start, start + step, start + 2 * step, element, swap, compare);
+        bh_sort3(middle - step, middle, middle + step, element, swap, compare);
+        bh_sort3(last - 2 * step, last - step, last, element, swap, compare);
+        bh_sort3(start + step, middle, last - step, element, swap, compare);
+    }
+    else
+        bh_sort3(start, middle, last, element, swap, compare);
+
+    /* Move pivot to the beginning of the range */
+    swap(start, middle, element);
+}
+
+static char *bh_sort_partition_right(char *start,
+                                     char *end,
+                                     size_t element,
+                                     bh_swap_cb_t swap,
+                                     bh_compare_cb_t compare,
+                                     int *partitioned)
+{
+    char *i, *j;
+
+    /* Elements less than pivot go left, other elements go right */
+    i = start + element;
+    j = end - element;
+    *partitioned = 1;
+
+    while (1)
+    {
+        while (i <= j && compare(i, start) < 0)
+            i += element;
+        while (i <= j && !(compare(j, start) < 0))
+            j -= element;
+
+        if (i > j)
+            break;
+
+        swap(i, j, element);
+        i += element;
+        j -= element;
+        *partitioned = 0;
+    }
+
+    /* Place pivot at its final position */
+    swap(start, j, element);
+    return j;
+}
+
+static char *bh_sort_partition_left(char *start,
+                                    char *end,
+                                    size_t element,
+                                    bh_swap_cb_t swap,
+                                    bh_compare_cb_t compare)
+{
+    char *i, *j;
+
+    /* Elements less or equal to pivot go left, other elements go right */
+    i = start + element;
+    j = end - element;
+
+    while (1)
+    {
+        while (i <= j && !(compare(start, i) < 0))
+            i += element;
+        while (i <= j && compare(start, j) < 0)
+            j -= element;
+
+        if (i > j)
+            break;
+
+        swap(i, j, element);
+        i += element;
+        j -= element;
+    }
+
+    /* Place pivot at its final position */
+    swap(start, j, element);
+    return j;
+}
+
+static void bh_sort_loop(char *start,
+                         char *end,
+                         size_t element,
+                         bh_swap_cb_t swap,
+                         bh_compare_cb_t compare,
+                         size_t depth,
+                         int leftmost)
+{
+    char *pivot;
+    size_t size, left, right;
+    int partitioned;
+
+    while (1)
     {
-        char *current, *left, *right;
+        size = (end - start) / element;
+
+        /* Small ranges are handled by insertion sort */
+        if (size <= BH_SORT_INSERT_THRESHOLD)
+        {
+            bh_sort_insert(start, end, element, swap, compare);
+            return;
+        }
+
+        bh_sort_pivot(start, size, element, swap, compare);
 
-        /* Calculate current and children pointers */
-        current = start + (i - 1) * element;
-        left = start + (current - start) * 2 + element;
-        right = left + element;
+        /*
+         * If predecessor is equal to the pivot - all elements equal to the
+         * pivot are placed left and skipped. This keeps sorting arrays with
+         * many duplicates close to linear.
+         */
+        if (!leftmost && !(compare(start - element, start) < 0))
+        {
+            start = bh_sort_partition_left(start, end, element, swap, compare) + element;
+            continue;
+        }
 
-        while (left < end)
+        pivot = bh_sort_partition_right(start, end, element, swap, compare, &partitioned);
+        left = (pivot - start) / element;
+        right = (end - pivot) / element - 1;
+
+        if (left < size / 8 || right < size / 8)
         {
-            char *biggest;
+            /* Too many bad partitions - fallback to heap sort */
+            if (!depth)
+            {
+                bh_sort_heap(start, element, size, compare);
+                return;
+            }
+            depth--;
 
-            /* Determine biggest child */
-            biggest = left;
-            if (right < end && compare(left, right) < 0)
-                biggest = right;
+            /* Break patterns that lead to bad partitions */
+            if (left >= BH_SORT_INSERT_THRESHOLD)
+            {
+                swap(start, start + (left / 4) * element, element);
+                swap(pivot - element, pivot - (left / 4) * element, element);
+            }
 
-            /* Compare biggest child with current */
-            if (compare(current, biggest) < 0)
+            if (right >= BH_SORT_INSERT_THRESHOLD)
             {
-                /* Swap content and recalculate children pointers */
-                bh_swap(current, biggest, element);
-                current = biggest;
-                left = start + (current - start) * 2 + element;
-                right = left + element;
+                swap(pivot + element, pivot + (1 + right / 4) * element, element);
+                swap(end - element, end - (right / 4) * element, element);
             }
-            else
-                break;
+        }
+        else if (partitioned)
+        {
+            /* Range looks sorted - try to finish it with insertion sort */
+            if (bh_sort_insert_partial(start, pivot, element, swap, compare) &&
+                bh_sort_insert_partial(pivot + element, end, element, swap, compare))
+                return;
+        }
+
+        /* Recurse into smaller part, iterate over the larger part */
+        if (left < right)
+        {
+            bh_sort_loop(start, pivot, element, swap, compare, depth, leftmost);
+            start = pivot + element;
+            leftmost = 0;
+        }
+        else
+        {
+            bh_sort_loop(pivot + element, end, element, swap, compare, depth, 0);
+            end = pivot;
         }
     }
 }
 
-void bh_heap_pop(void *array,
-                 size_t element,
-                 size_t size,
-                 bh_compare_cb_t compare)
+void bh_sort(void *array,
+             size_t element,
+             size_t size,
+             bh_compare_cb_t compare)
 {
-    char *start, *end, *current, *left, *right;
+    char *start, *end, *current;
+    size_t depth;
+    bh_swap_cb_t swap;
 
-    if (size <= 1)
+    if (size < 2)
         return;
 
     start = (char *)array;
-    end = start + (size - 1) * element;
-    current = start;
+    end = start + size * element;
+    swap = bh_swap_func(element);
+
+    /* Detect already sorted array */
+    current = start + element;
+    while (current < end && !(compare(current, current - element) < 0))
+        current += element;
+
+    if (current == end)
+        return;
+
+    /* Detect reverse sorted array */
+    if (current == start + element)
+    {
+        while (current < end && !(compare(current - element, current) < 0))
+            current += element;
+
+        if (current == end)
+        {
+            bh_sort_reverse(start, end, element, swap);
+            return;
+        }
+    }
+
+    /* Calculate amount of allowed bad partitions (log2(size)) */
+    for (depth = 0; size; size >>= 1)
+        depth++;
+
+    bh_sort_loop(start, end, element, swap, compare, depth, 1);
+}
+
+static void bh_heap_sift(char *start,
+                         char *end,
+                         char *current,
+                         size_t element,
+                         bh_swap_cb_t swap,
+                         bh_compare_cb_t compare)
+{
+    char *left, *right, *biggest;
+
+    /* Calculate children pointers */
     left = start + (current - start) * 2 + element;
     right = left + element;
 
-    bh_swap(current, end, element);
-
     while (left < end)
     {
-        char *biggest;
-
+        /* Determine biggest child */
         biggest = left;
         if (right < end && compare(left, right) < 0)
             biggest = right;
 
+        /* Compare biggest child with current */
         if (compare(current, biggest) < 0)
         {
-            bh_swap(current, biggest, element);
+            /* Swap content and recalculate children pointers */
+            swap(current, biggest, element);
             current = biggest;
             left = start + (current - start) * 2 + element;
             right = left + element;
@@ -128,6 +539,61 @@ void bh_heap_pop(void *array,
     }
 }
 
+void bh_heap_make(void *array,
+                  size_t element,
+                  size_t size,
+                  bh_compare_cb_t compare)
+{
+    char *start, *end;
+    size_t i;
+    bh_swap_cb_t swap;
+
+    /* Calculate start and end pointers of the array */
+    start = (char *)array;
+    end = start + size * element;
+    swap = bh_swap_func(element);
+
+    /* Bottom up heapify algorithm */
+    for (i = size / 2 + 1; i; --i)
+        bh_heap_sift(start, end, start + (i - 1) * element, element, swap, compare);
+}
+
+void bh_heap_pop(void *array,
+                 size_t element,
+                 size_t size,
+                 bh_compare_cb_t compare)
+{
+    char *start, *end;
+    bh_swap_cb_t swap;
+
+    if (size <= 1)
+        return;
+
+    start = (char *)array;
+    end = start + (size - 1) * element;
+    swap = bh_swap_func(element);
+
+    swap(start, end, element);
+    bh_heap_sift(start, end, start, element, swap, compare);
+}
+
+void bh_heap_replace(const void *item,
+                     void *array,
+                     size_t element,
+                     size_t size,
+                     bh_compare_cb_t compare)
+{
+    char *start;
+
+    if (!size)
+        return;
+
+    /* Overwrite top element and restore heap property */
+    start = (char *)array;
+    memmove(start, item, element);
+    bh_heap_sift(start, start + size * element, start, element, bh_swap_func(element), compare);
+}
+
 void bh_heap_push(const void *item,
                   void *array,
                   size_t element,
@@ -135,10 +601,12 @@ void bh_heap_push(const void *item,
                   bh_compare_cb_t compare)
 {
     char *start, *end, *current;
+    bh_swap_cb_t swap;
 
     start = (char *)array;
     end = start + size * element;
     current = end;
+    swap = bh_swap_func(element);
 
     memmove(current, item, element);
     while (current > start)
@@ -148,7 +616,7 @@ void bh_heap_push(const void *item,
         parent = start + (((current - start) / element - 1) / 2) * element;
         if (compare(parent, current) < 0)
         {
-            bh_swap(parent, current, element);
+            swap(parent, current, element);
             current = parent;
         }
         else
@@ -156,3 +624,1336 @@ void bh_heap_push(const void *item,
     }
 }
 
+static int bh_sort_precedes(const char *item,
+                            const void *key,
+                            bh_compare_cb_t compare,
+                            int right)
+{
+    /*
+     * Left mode: item is less than the key (lower bound).
+     * Right mode: item is less or equal to the key (upper bound).
+     */
+    if (right)
+        return !(compare(key, item) < 0);
+
+    return compare(item, key) < 0;
+}
+
+static size_t bh_sort_gallop(const void *key,
+                             char *base,
+                             size_t size,
+                             size_t element,
+                             bh_compare_cb_t compare,
+                             int right,
+                             int from_end)
+{
+    size_t low, high, step, middle;
+
+    /* Exponential search from one of the ends to find search window */
+    step = 1;
+    if (from_end)
+    {
+        high = size;
+        while (high >= step && !bh_sort_precedes(base + (high - step) * element, key, compare, right))
+        {
+            high -= step;
+            step <<= 1;
+        }
+        low = (high >= step) ? (high - step + 1) : (0);
+    }
+    else
+    {
+        low = 0;
+        while (low + step <= size && bh_sort_precedes(base + (low + step - 1) * element, key, compare, right))
+        {
+            low += step;
+            step <<= 1;
+        }
+        high = (low + step - 1 < size) ? (low + step - 1) : (size);
+    }
+
+    /* Binary search within the window */
+    while (low < high)
+    {
+        middle = low + (high - low) / 2;
+        if (bh_sort_precedes(base + middle * element, key, compare, right))
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    return low;
+}
+
+static void bh_sort_rotate(char *start,
+                           char *middle,
+                           char *end,
+                           size_t element,
+                           bh_swap_cb_t swap)
+{
+    /* Rotate range in-place using three reversals */
+    bh_sort_reverse(start, middle, element, swap);
+    bh_sort_reverse(middle, end, element, swap);
+    bh_sort_reverse(start, end, element, swap);
+}
+
+static void bh_sort_merge_inplace(char *start,
+                                  size_t left,
+                                  size_t right,
+                                  size_t element,
+                                  bh_swap_cb_t swap,
+                                  bh_compare_cb_t compare)
+{
+    char *middle, *first_cut, *second_cut;
+    size_t left_cut, right_cut;
+
+    while (left && right)
+    {
+        middle = start + left * element;
+
+        /* Two elements left - simply swap them if needed */
+        if (left + right == 2)
+        {
+            if (compare(middle, start) < 0)
+                swap(start, middle, element);
+            return;
+        }
+
+        /* Split the larger run in half and find matching split point */
+        if (left > right)
+        {
+            left_cut = left / 2;
+            first_cut = start + left_cut * element;
+            right_cut = bh_sort_gallop(first_cut, middle, right, element, compare, 0, 0);
+            second_cut = middle + right_cut * element;
+        }
+        else
+        {
+            right_cut = right / 2;
+            second_cut = middle + right_cut * element;
+            left_cut = bh_sort_gallop(second_cut, start, left, element, compare, 1, 0);
+            first_cut = start + left_cut * element;
+        }
+
+        /* Swap inner parts and merge both halves */
+        bh_sort_rotate(first_cut, middle, second_cut, element, swap);
+        middle = first_cut + right_cut * element;
+
+        if (left_cut + right_cut < left + right - left_cut - right_cut)
+        {
+            bh_sort_merge_inplace(start, left_cut, right_cut, element, swap, compare);
+            start = middle;
+            left -= left_cut;
+            right -= right_cut;
+        }
+        else
+        {
+            bh_sort_merge_inplace(middle, left - left_cut, right - right_cut, element, swap, compare);
+            left = left_cut;
+            right = right_cut;
+        }
+    }
+}
+
+static void bh_sort_merge_low(bh_sort_state_t *state,
+                              char *start,
+                              size_t left,
+                              size_t right)
+{
+    char *a, *b, *to;
+    size_t element, wins_a, wins_b, count;
+    bh_compare_cb_t compare;
+
+    element = state->element;
+    compare = state->compare;
+
+    /* Move left run into scratch and merge from the beginning */
+    memcpy(state->scratch, start, left * element);
+    a = state->scratch;
+    b = start + left * element;
+    to = start;
+    wins_a = wins_b = 0;
+
+    while (left && right)
+    {
+        if (compare(b, a) < 0)
+        {
+            memmove(to, b, element);
+            b += element;
+            right--;
+            wins_a = 0;
+            wins_b++;
+        }
+        else
+        {
+            memcpy(to, a, element);
+            a += element;
+            left--;
+            wins_a++;
+            wins_b = 0;
+        }
+        to += element;
+
+        /* One run keeps winning - gallop over it */
+        if (wins_a >= BH_SORT_MIN_GALLOP && left && right)
+        {
+            count = bh_sort_gallop(b, a, left, element, compare, 1, 0);
+            memcpy(to, a, count * element);
+            a += count * element;
+            to += count * element;
+            left -= count;
+            wins_a = 0;
+        }
+        else if (wins_b >= BH_SORT_MIN_GALLOP && left && right)
+        {
+            count = bh_sort_gallop(a, b, right, element, compare, 0, 0);
+            memmove(to, b, count * element);
+            b += count * element;
+            to += count * element;
+            right -= count;
+            wins_b = 0;
+        }
+    }
+
+    /* Rest of the right run is already in place */
+    if (left)
+        memcpy(to, a, left * element);
+}
+
+static void bh_sort_merge_high(bh_sort_state_t *state,
+                               char *start,
+                               size_t left,
+                               size_t right)
+{
+    char *a, *b, *to;
+    size_t element, wins_a, wins_b, count;
+    bh_compare_cb_t compare;
+
+    element = state->element;
+    compare = state->compare;
+
+    /* Move right run into scratch and merge from the end */
+    memcpy(state->scratch, start + left * element, right * element);
+    a = start + left * element;
+    b = state->scratch + right * element;
+    to = start + (left + right) * element;
+    wins_a = wins_b = 0;
+
+    while (left && right)
+    {
+        to -= element;
+        if (compare(b - element, a - element) < 0)
+        {
+            a -= element;
+            memmove(to, a, element);
+            left--;
+            wins_a++;
+            wins_b = 0;
+        }
+        else
+        {
+            b -= element;
+            memcpy(to, b, element);
+            right--;
+            wins_a = 0;
+            wins_b++;
+        }
+
+        /* One run keeps winning - gallop over it */
+        if (wins_a >= BH_SORT_MIN_GALLOP && left && right)
+        {
+            count = left - bh_sort_gallop(b - element, start, left, element, compare, 1, 1);
+            a -= count * element;
+            to -= count * element;
+            memmove(to, a, count * element);
+            left -= count;
+            wins_a = 0;
+        }
+        else if (wins_b >= BH_SORT_MIN_GALLOP && left && right)
+        {
+            count = right - bh_sort_gallop(a - element, state->scratch, right, element, compare, 0, 1);
+            b -= count * element;
+            to -= count * element;
+            memcpy(to, b, count * element);
+            right -= count;
+            wins_b = 0;
+        }
+    }
+
+    /* Rest of the left run is already in place */
+    if (right)
+        memcpy(start, state->scratch, right * element);
+}
+
+static void bh_sort_merge_at(bh_sort_state_t *state,
+                             size_t index)
+{
+    char *start, *middle;
+    size_t left, right, skip;
+
+    start = state->runs[index].start;
+    left = state->runs[index].size;
+    right = state->runs[index + 1].size;
+    middle = start + left * state->element;
+
+    /* Update run stack */
+    state->runs[index].size = left + right;
+    if (index + 2 < state->count)
+        state->runs[index + 1] = state->runs[index + 2];
+    state->count--;
+
+    /* Skip elements of the left run that are already in place */
+    skip = bh_sort_gallop(middle, start, left, state->element, state->compare, 1, 0);
+    start += skip * state->element;
+    left -= skip;
+    if (!left)
+        return;
+
+    /* Skip elements of the right run that are already in place */
+    right = bh_sort_gallop(middle - state->element, middle, right, state->element, state->compare, 0, 1);
+    if (!right)
+        return;
+
+    if (!state->scratch)
+        bh_sort_merge_inplace(start, left, right, state->element, state->swap, state->compare);
+    else if (left <= right)
+        bh_sort_merge_low(state, start, left, right);
+    else
+        bh_sort_merge_high(state, start, left, right);
+}
+
+static void bh_sort_merge_collapse(bh_sort_state_t *state)
+{
+    bh_sort_run_t *runs;
+    size_t index;
+
+    /* Maintain run stack invariants (sizes grow at least like Fibonacci) */
+    runs = state->runs;
+    while (state->count > 1)
+    {
+        index = state->count - 2;
+        if ((index > 0 && runs[index - 1].size <= runs[index].size + runs[index + 1].size) ||
+            (index > 1 && runs[index - 2].size <= runs[index - 1].size + runs[index].size))
+        {
+            if (runs[index - 1].size < runs[index + 1].size)
+                index--;
+        }
+        else if (runs[index].size > runs[index + 1].size)
+            break;
+
+        bh_sort_merge_at(state, index);
+    }
+}
+
+static size_t bh_sort_min_run(size_t size)
+{
+    size_t rest;
+
+    /* Calculate minimal run size in range [32; 64] */
+    rest = 0;
+    while (size >= 64)
+    {
+        rest |= size & 1;
+        size >>= 1;
+    }
+
+    return size + rest;
+}
+
+void bh_sort_stable(void *array,
+                    size_t element,
+                    size_t size,
+                    bh_compare_cb_t compare,
+                    void *scratch)
+{
+    bh_sort_state_t state;
+    char *start, *end, *current;
+    size_t min_run, run;
+    bh_swap_cb_t swap;
+
+    start = (char *)array;
+    end = start + size * element;
+    swap = bh_swap_func(element);
+
+    /* Small arrays are handled by insertion sort */
+    if (size < 64)
+    {
+        bh_sort_insert(start, end, element, swap, compare);
+        return;
+    }
+
+    state.element = element;
+    state.swap = swap;
+    state.compare = compare;
+    state.scratch = (char *)scratch;
+    state.count = 0;
+    min_run = bh_sort_min_run(size);
+
+    while (start < end)
+    {
+        /* Find natural run (strictly descending runs are reversed) */
+        current = start + element;
+        if (current < end && compare(current, start) < 0)
+        {
+            while (current < end && compare(current, current - element) < 0)
+                current += element;
+            bh_sort_reverse(start, current, element, swap);
+        }
+        else
+        {
+            while (current < end && !(compare(current, current - element) < 0))
+                current += element;
+        }
+
+        /* Extend short runs with insertion sort */
+        run = (current - start) / element;
+        if (run < min_run)
+        {
+            run = (size_t)(end - start) / element;
+            if (run > min_run)
+                run = min_run;
+            bh_sort_insert(start, start + run * element, element, swap, compare);
+        }
+
+        /* Push run onto the stack and merge runs if needed */
+        state.runs[state.count].start = start;
+        state.runs[state.count].size = run;
+        state.count++;
+        bh_sort_merge_collapse(&state);
+
+        start += run * element;
+    }
+
+    /* Merge remaining runs */
+    while (state.count > 1)
+    {
+        run = state.count - 2;
+        if (run > 0 && state.runs[run - 1].size < state.runs[run + 1].size)
+            run--;
+        bh_sort_merge_at(&state, run);
+    }
+}
+
+static void bh_sort_parallel_sort(void *data)
+{
+    bh_sort_task_t *task;
+
+    task = (bh_sort_task_t *)data;
+    bh_sort(task->left, task->element, task->left_size, task->compare);
+}
+
+static void bh_sort_parallel_merge(void *data)
+{
+    bh_sort_task_t *task;
+    char *left, *right, *left_end, *right_end, *to;
+    size_t element;
+
+    task = (bh_sort_task_t *)data;
+    element = task->element;
+    left = task->left;
+    right = task->right;
+    left_end = left + task->left_size * element;
+    right_end = right + task->right_size * element;
+    to = task->to;
+
+    /* Merge two runs into destination (left run wins ties) */
+    while (left < left_end && right < right_end)
+    {
+        if (task->compare(right, left) < 0)
+        {
+            memcpy(to, right, element);
+            right += element;
+        }
+        else
+        {
+            memcpy(to, left, element);
+            left += element;
+        }
+        to += element;
+    }
+
+    /* Copy the rest */
+    if (left < left_end)
+        memcpy(to, left, left_end - left);
+    if (right < right_end)
+        memcpy(to, right, right_end - right);
+}
+
+static size_t bh_sort_parallel_split(char *left,
+                                     size_t left_size,
+                                     char *right,
+                                     size_t right_size,
+                                     size_t diagonal,
+                                     size_t element,
+                                     bh_compare_cb_t compare)
+{
+    size_t low, high, middle;
+
+    /* Find amount of left run elements among first diagonal elements */
+    low = (diagonal > right_size) ? (diagonal - right_size) : (0);
+    high = (diagonal < left_size) ? (diagonal) : (left_size);
+
+    while (low < high)
+    {
+        middle = low + (high - low) / 2;
+        if (!(compare(right + (diagonal - middle - 1) * element, left + middle * element) < 0))
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    return low;
+}
+
+static int bh_sort_parallel_run(bh_tpool_t *pool,
+                                bh_thread_cb_t func,
+                                bh_sort_task_t *tasks,
+                                size_t count)
+{
+    size_t i;
+    int queued;
+
+    /* Submit tasks to the pool (or run them in place if pool can't) */
+    queued = 0;
+    for (i = 0; i < count; i++)
+    {
+        if (bh_tpool_job(pool, func, tasks + i))
+            func(tasks + i);
+        else
+            queued = 1;
+    }
+
+    if (queued)
+        return bh_tpool_join(pool);
+
+    return 0;
+}
+
+int bh_sort_parallel(bh_tpool_t *pool,
+                     void *array,
+                     size_t element,
+                     size_t size,
+                     bh_compare_cb_t compare)
+{
+    bh_sort_task_t *tasks, *task;
+    size_t threads, chunks, parts, count, i, j, offset, run, total;
+    size_t diagonal, next, split, next_split;
+    char *from, *to, *buffer;
+
+    /* Small arrays or pools without threads are sorted sequentially */
+    threads = (pool) ? (bh_tpool_size(pool)) : (0);
+    if (threads < 2 || size < BH_SORT_PARALLEL_THRESHOLD)
+    {
+        bh_sort(array, element, size, compare);
+        return 0;
+    }
+
+    /* Merge rounds need tasks for each merge part and for each pair of runs */
+    chunks = threads;
+    if (size / chunks < BH_SORT_PARALLEL_THRESHOLD / 2)
+        chunks = size / (BH_SORT_PARALLEL_THRESHOLD / 2);
+
+    buffer = malloc(size * element);
+    tasks = malloc(sizeof(*tasks) * (2 * chunks + threads));
+    if (!buffer || !tasks)
+    {
+        if (buffer)
+            free(buffer);
+        if (tasks)
+            free(tasks);
+        return -1;
+    }
+
+    /* Sort chunks independently */
+    run = (size + chunks - 1) / chunks;
+    for (i = 0, count = 0; i < size; i += run, count++)
+    {
+        task = tasks + count;
+        task->left = (char *)array + i * element;
+        task->left_size = (size - i < run) ? (size - i) : (run);
+        task->element = element;
+        task->compare = compare;
+    }
+
+    if (bh_sort_parallel_run(pool, bh_sort_parallel_sort, tasks, count))
+    {
+        free(tasks);
+        free(buffer);
+        return -1;
+    }
+
+    /* Merge pairs of adjacent runs, until there is only one run left */
+    from = (char *)array;
+    to = buffer;
+    for (; run < size; run *= 2)
+    {
+        count = 0;
+        for (offset = 0; offset < size; offset += 2 * run)
+        {
+            total = (size - offset < 2 * run) ? (size - offset) : (2 * run);
+
+            /* Split each merge into parts proportional to its size */
+            parts = (threads * total + size - 1) / size;
+            split = 0;
+            diagonal = 0;
+            for (j = 0; j < parts; j++)
+            {
+                task = tasks + count++;
+                task->element = element;
+                task->compare = compare;
+
+                next = total * (j + 1) / parts;
+                if (total <= run)
+                    next_split = next;
+                else
+                    next_split = bh_sort_parallel_split(from + offset * element, run,
+                                                        from + (offset + run) * element,
+                                                        total - run, next, element, compare);
+
+                task->left = from + (offset + split) * element;
+                task->left_size = next_split - split;
+                task->right = from + (offset + (total < run ? total : run) + diagonal - split) * element;
+                task->right_size = (next - next_split) - (diagonal - split);
+                task->to = to + (offset + diagonal) * element;
+
+                split = next_split;
+                diagonal = next;
+            }
+        }
+
+        if (bh_sort_parallel_run(pool, bh_sort_parallel_merge, tasks, count))
+        {
+            free(tasks);
+            free(buffer);
+            return -1;
+        }
+
+        /* Swap buffers */
+        from = to;
+        to = (from == buffer) ? ((char *)array) : (buffer);
+    }
+
+    /* Copy result back into the array */
+    if (from != (char *)array)
+        memcpy(array, from, size * element);
+
+    free(tasks);
+    free(buffer);
+    return 0;
+}
+
+static unsigned int bh_radix_digit(const bh_radix_t *radix,
+                                   const char *item,
+                                   size_t digit)
+{
+    const unsigned char *key;
+    unsigned int value;
+
+    /* Digits are counted from the most significant byte */
+    key = (const unsigned char *)item + radix->offset;
+    value = key[(radix->little) ? (radix->width - 1 - digit) : (digit)];
+
+    if (radix->flags & BH_SORT_RADIX_FLOAT)
+    {
+        /* Negative values are inverted, positive values get sign bit set */
+        if (key[(radix->little) ? (radix->width - 1) : (0)] & 0x80)
+            value ^= 0xFF;
+        else if (!digit)
+            value ^= 0x80;
+    }
+    else if ((radix->flags & BH_SORT_RADIX_SIGNED) && !digit)
+        value ^= 0x80;
+
+    return value;
+}
+
+static int bh_radix_less(const bh_radix_t *radix,
+                         const char *a,
+                         const char *b,
+                         size_t digit)
+{
+    unsigned int left, right;
+
+    /* Compare remaining digits of two keys */
+    for (; digit < radix->width; digit++)
+    {
+        left = bh_radix_digit(radix, a, digit);
+        right = bh_radix_digit(radix, b, digit);
+        if (left != right)
+            return left < right;
+    }
+
+    return 0;
+}
+
+static void bh_radix_insert(const bh_radix_t *radix,
+                            char *start,
+                            size_t size,
+                            size_t digit)
+{
+    char *end, *i, *j;
+    size_t element;
+    bh_swap_cb_t swap;
+
+    /* Insertion sort for small ranges */
+    element = radix->element;
+    swap = radix->swap;
+    end = start + size * element;
+    for (i = start + element; i < end; i += element)
+    {
+        for (j = i; j > start && bh_radix_less(radix, j, j - element, digit); j -= element)
+            swap(j, j - element, element);
+    }
+}
+
+static uint64_t bh_radix_key(const bh_radix_t *radix,
+                             const char *item)
+{
+    const unsigned char *key;
+    uint64_t value, sign;
+    uint32_t value32;
+    uint16_t value16;
+    size_t i;
+
+    /* Load key as unsigned integer (native keys are loaded directly) */
+    key = (const unsigned char *)item + radix->offset;
+    switch ((radix->flags & BH_SORT_RADIX_BINARY) ? (0) : (radix->width))
+    {
+    case 1: value = key[0]; break;
+    case 2: memcpy(&value16, key, 2); value = value16; break;
+    case 4: memcpy(&value32, key, 4); value = value32; break;
+    case 8: memcpy(&value, key, 8); break;
+    default:
+        value = 0;
+        for (i = 0; i < radix->width; i++)
+            value = (value << 8) | key[(radix->little) ? (radix->width - 1 - i) : (i)];
+        break;
+    }
+
+    /* Map signed and floating point keys onto unsigned keys */
+    sign = (uint64_t)1 << (radix->width * 8 - 1);
+    if (radix->flags & BH_SORT_RADIX_FLOAT)
+    {
+        if (value & sign)
+            value = ~value & (sign | (sign - 1));
+        else
+            value ^= sign;
+    }
+    else if (radix->flags & BH_SORT_RADIX_SIGNED)
+        value ^= sign;
+
+    return value;
+}
+
+static void bh_radix_lsd(const bh_radix_t *radix,
+                         char *array,
+                         char *buffer,
+                         size_t size)
+{
+    size_t counts[BH_RADIX_LSD_WIDTH][256];
+    size_t digit, i, sum, tmp, element;
+    char *from, *to, *item;
+    uint64_t key;
+
+    element = radix->element;
+    memset(counts, 0, sizeof(counts));
+
+    /* Build histograms for all digits in one pass */
+    for (i = 0, item = array; i < size; i++, item += element)
+    {
+        key = bh_radix_key(radix, item);
+        for (digit = 0; digit < radix->width; digit++)
+            counts[digit][(key >> (digit * 8)) & 0xFF]++;
+    }
+
+    /* Scatter elements starting from least significant digit */
+    from = array;
+    to = buffer;
+    for (digit = 0; digit < radix->width; digit++)
+    {
+        /* Skip digit if all elements have the same value */
+        key = bh_radix_key(radix, from);
+        if (counts[digit][(key >> (digit * 8)) & 0xFF] == size)
+            continue;
+
+        /* Convert counts to offsets */
+        for (i = 0, sum = 0; i < 256; i++)
+        {
+            tmp = counts[digit][i];
+            counts[digit][i] = sum;
+            sum += tmp;
+        }
+
+        for (i = 0, item = from; i < size; i++, item += element)
+        {
+            key = bh_radix_key(radix, item);
+            memcpy(to + (counts[digit][(key >> (digit * 8)) & 0xFF]++) * element, item, element);
+        }
+
+        item = from;
+        from = to;
+        to = item;
+    }
+
+    /* Copy result back into the array */
+    if (from != array)
+        memcpy(array, from, size * element);
+}
+
+static void bh_radix_msd(const bh_radix_t *radix,
+                         char *array,
+                         char *buffer,
+                         size_t size,
+                         size_t digit)
+{
+    size_t counts[256], offsets[256];
+    size_t i, sum, element;
+    char *item;
+
+    element = radix->element;
+    while (digit < radix->width)
+    {
+        /* Small ranges are handled by insertion sort */
+        if (size <= BH_RADIX_INSERT_THRESHOLD)
+        {
+            bh_radix_insert(radix, array, size, digit);
+            return;
+        }
+
+        memset(counts, 0, sizeof(counts));
+        for (i = 0, item = array; i < size; i++, item += element)
+            counts[bh_radix_digit(radix, item, digit)]++;
+
+        /* Skip digit if all elements have the same value */
+        if (counts[bh_radix_digit(radix, array, digit)] == size)
+        {
+            digit++;
+            continue;
+        }
+
+        /* Scatter elements into buckets and copy them back */
+        for (i = 0, sum = 0; i < 256; i++)
+        {
+            offsets[i] = sum;
+            sum += counts[i];
+        }
+
+        for (i = 0, item = array; i < size; i++, item += element)
+            memcpy(buffer + (offsets[bh_radix_digit(radix, item, digit)]++) * element, item, element);
+        memcpy(array, buffer, size * element);
+
+        /* Sort each bucket by the next digit */
+        for (i = 0, item = array; i < 256; item += counts[i++] * element)
+        {
+            if (counts[i] > 1)
+                bh_radix_msd(radix, item, buffer, counts[i], digit + 1);
+        }
+        return;
+    }
+}
+
+int bh_sort_radix(void *array,
+                  size_t element,
+                  size_t size,
+                  size_t key_offset,
+                  size_t key_width,
+                  int flags)
+{
+    bh_radix_t radix;
+    char *buffer;
+    unsigned int endian;
+
+    if (!key_width || key_offset + key_width > element)
+        return -1;
+
+    /* Determine byte order of the keys */
+    endian = 1;
+    radix.element = element;
+    radix.swap = bh_swap_func(element);
+    radix.offset = key_offset;
+    radix.width = key_width;
+    radix.flags = flags;
+    radix.little = !(flags & BH_SORT_RADIX_BINARY) && *(unsigned char *)&endian;
+
+    if (size <= BH_RADIX_INSERT_THRESHOLD)
+    {
+        bh_radix_insert(&radix, array, size, 0);
+        return 0;
+    }
+
+    buffer = malloc(size * element);
+    if (!buffer)
+        return -1;
+
+    /* Short keys are sorted with LSD, long keys are sorted with MSD */
+    if (key_width <= BH_RADIX_LSD_WIDTH)
+        bh_radix_lsd(&radix, array, buffer, size);
+    else
+        bh_radix_msd(&radix, array, buffer, size, 0);
+
+    free(buffer);
+    return 0;
+}
+
+void bh_partial_sort(void *array,
+                     size_t element,
+                     size_t size,
+                     size_t count,
+                     bh_compare_cb_t compare)
+{
+    char *start, *end, *heap_end, *current;
+    bh_swap_cb_t swap;
+
+    if (count > size)
+        count = size;
+    if (!count)
+        return;
+
+    start = (char *)array;
+    end = start + size * element;
+    heap_end = start + count * element;
+    swap = bh_swap_func(element);
+
+    /* Keep smallest elements in the heap */
+    bh_heap_make(start, element, count, compare);
+    for (current = heap_end; current < end; current += element)
+    {
+        if (compare(current, start) < 0)
+        {
+            swap(current, start, element);
+            bh_heap_sift(start, heap_end, start, element, swap, compare);
+        }
+    }
+
+    /* Sort the heap */
+    while (count)
+        bh_heap_pop(start, element, count--, compare);
+}
+
+void bh_nth_element(void *array,
+                    size_t element,
+                    size_t size,
+                    size_t nth,
+                    bh_compare_cb_t compare)
+{
+    char *start, *end, *target, *pivot;
+    size_t depth, count;
+    bh_swap_cb_t swap;
+    int partitioned;
+
+    if (nth >= size)
+        return;
+
+    start = (char *)array;
+    end = start + size * element;
+    target = start + nth * element;
+    swap = bh_swap_func(element);
+
+    /* Calculate recursion depth limit (2 * log2(size)) */
+    for (depth = 0, count = size; count; count >>= 1)
+        depth += 2;
+
+    while ((size_t)(end - start) / element > BH_SORT_INSERT_THRESHOLD)
+    {
+        /* Bad pivots - fallback to heap select */
+        if (!depth--)
+        {
+            count = (target - start) / element + 1;
+            bh_partial_sort(start, element, (end - start) / element, count, compare);
+            return;
+        }
+
+        bh_sort_pivot(start, (end - start) / element, element, swap, compare);
+
+        /* Skip elements equal to the predecessor (see bh_sort_loop) */
+        if (start > (char *)array && !(compare(start - element, start) < 0))
+        {
+            pivot = bh_sort_partition_left(start, end, element, swap, compare);
+            if (target <= pivot)
+                return;
+
+            start = pivot + element;
+            continue;
+        }
+
+        /* Continue with the part containing target element */
+        pivot = bh_sort_partition_right(start, end, element, swap, compare, &partitioned);
+        if (pivot == target)
+            return;
+        else if (target < pivot)
+            end = pivot;
+        else
+            start = pivot + element;
+    }
+
+    bh_sort_insert(start, end, element, swap, compare);
+}
+
+size_t bh_partition(void *array,
+                    size_t element,
+                    size_t size,
+                    bh_predicate_cb_t predicate,
+                    void *data)
+{
+    char *start, *end;
+    bh_swap_cb_t swap;
+
+    start = (char *)array;
+    end = start + size * element;
+    swap = bh_swap_func(element);
+
+    for (;;)
+    {
+        /* Find misplaced elements from both ends and swap them */
+        while (start < end && predicate(start, data))
+            start += element;
+        if (start == end)
+            break;
+
+        end -= element;
+        while (start < end && !predicate(end, data))
+            end -= element;
+        if (start == end)
+            break;
+
+        swap(start, end, element);
+        start += element;
+    }
+
+    return (start - (char *)array) / element;
+}
+
+static char *bh_partition_inplace(char *start,
+                                  size_t size,
+                                  size_t element,
+                                  bh_swap_cb_t swap,
+                                  bh_predicate_cb_t predicate,
+                                  void *data)
+{
+    char *left, *middle, *right;
+    size_t half;
+
+    if (size < 2)
+        return start + (size && predicate(start, data)) * element;
+
+    /* Partition both halves and swap inner parts */
+    half = size / 2;
+    middle = start + half * element;
+    left = bh_partition_inplace(start, half, element, swap, predicate, data);
+    right = bh_partition_inplace(middle, size - half, element, swap, predicate, data);
+
+    bh_sort_rotate(left, middle, right, element, swap);
+    return left + (right - middle);
+}
+
+size_t bh_stable_partition(void *array,
+                           size_t element,
+                           size_t size,
+                           bh_predicate_cb_t predicate,
+                           void *data,
+                           void *scratch)
+{
+    char *current, *end, *to, *spill;
+
+    current = (char *)array;
+    end = current + size * element;
+
+    if (!scratch)
+    {
+        to = bh_partition_inplace(current, size, element, bh_swap_func(element), predicate, data);
+        return (to - (char *)array) / element;
+    }
+
+    /* Compact matching elements, spill others into the scratch buffer */
+    to = current;
+    spill = (char *)scratch;
+    for (; current < end; current += element)
+    {
+        if (predicate(current, data))
+        {
+            if (to != current)
+                memcpy(to, current, element);
+            to += element;
+        }
+        else
+        {
+            memcpy(spill, current, element);
+            spill += element;
+        }
+    }
+
+    memcpy(to, scratch, spill - (char *)scratch);
+    return (to - (char *)array) / element;
+}
+
+size_t bh_unique(void *array,
+                 size_t element,
+                 size_t size,
+                 bh_compare_cb_t compare)
+{
+    char *current, *end, *to;
+
+    if (size < 2)
+        return size;
+
+    /* Compare with the last kept element */
+    to = (char *)array;
+    end = to + size * element;
+    for (current = to + element; current < end; current += element)
+    {
+        if (compare(to, current))
+        {
+            to += element;
+            if (to != current)
+                memcpy(to, current, element);
+        }
+    }
+
+    return (to - (char *)array) / element + 1;
+}
+
+static char *bh_search(const void *key,
+                       char *start,
+                       size_t element,
+                       size_t size,
+                       bh_compare_cb_t compare,
+                       int right)
+{
+    char *middle;
+    size_t half;
+
+    if (!size)
+        return start;
+
+    /* Branchless binary search: only base pointer is conditionally moved */
+    while (size > 1)
+    {
+        half = size / 2;
+        middle = start + half * element;
+        BH_PREFETCH(start + (half / 2) * element);
+        BH_PREFETCH(middle + (half / 2) * element);
+        start = (bh_sort_precedes(middle, key, compare, right)) ? (middle) : (start);
+        size -= half;
+    }
+
+    return start + bh_sort_precedes(start, key, compare, right) * element;
+}
+
+void *bh_lower_bound(const void *key,
+                     void *array,
+                     size_t element,
+                     size_t size,
+                     bh_compare_cb_t compare)
+{
+    return bh_search(key, (char *)array, element, size, compare, 0);
+}
+
+void *bh_upper_bound(const void *key,
+                     void *array,
+                     size_t element,
+                     size_t size,
+                     bh_compare_cb_t compare)
+{
+    return bh_search(key, (char *)array, element, size, compare, 1);
+}
+
+void bh_equal_range(const void *key,
+                    void *array,
+                    size_t element,
+                    size_t size,
+                    bh_compare_cb_t compare,
+                    void **first,
+                    void **last)
+{
+    char *lower;
+
+    /* Upper bound can't be lower than lower bound */
+    lower = bh_search(key, (char *)array, element, size, compare, 0);
+    size -= (lower - (char *)array) / element;
+
+    *first = lower;
+    *last = bh_search(key, lower, element, size, compare, 1);
+}
+
+static size_t bh_eytzinger_fill(const char *from,
+                                char *to,
+                                size_t element,
+                                size_t size,
+                                size_t index,
+                                size_t node)
+{
+    /* In-order traversal of the implicit tree (nodes are 1-based) */
+    if (node <= size)
+    {
+        index = bh_eytzinger_fill(from, to, element, size, index, node * 2);
+        memcpy(to + (node - 1) * element, from + index * element, element);
+        index = bh_eytzinger_fill(from, to, element, size, index + 1, node * 2 + 1);
+    }
+
+    return index;
+}
+
+void bh_eytzinger_make(const void *array,
+                       void *out,
+                       size_t element,
+                       size_t size)
+{
+    bh_eytzinger_fill((const char *)array, (char *)out, element, size, 0, 1);
+}
+
+static void *bh_eytzinger_search(const void *key,
+                                 void *array,
+                                 size_t element,
+                                 size_t size,
+                                 bh_compare_cb_t compare,
+                                 int right)
+{
+    char *start;
+    size_t node;
+
+    start = (char *)array;
+    node = 1;
+
+    /* Descend the tree, prefetching nodes four levels below */
+    while (node <= size)
+    {
+        if (node * 16 <= size)
+            BH_PREFETCH(start + (node * 16 - 1) * element);
+        node = node * 2 + bh_sort_precedes(start + (node - 1) * element, key, compare, right);
+    }
+
+    /* Undo right turns and the last left turn to find the answer */
+    while (node & 1)
+        node >>= 1;
+    node >>= 1;
+
+    if (!node)
+        return NULL;
+
+    return start + (node - 1) * element;
+}
+
+void *bh_eytzinger_lower_bound(const void *key,
+                               void *array,
+                               size_t element,
+                               size_t size,
+                               bh_compare_cb_t compare)
+{
+    return bh_eytzinger_search(key, array, element, size, compare, 0);
+}
+
+void *bh_eytzinger_upper_bound(const void *key,
+                               void *array,
+                               size_t element,
+                               size_t size,
+                               bh_compare_cb_t compare)
+{
+    return bh_eytzinger_search(key, array, element, size, compare, 1);
+}
+
+static int bh_merge_ready(bh_merge_run_t *run)
+{
+    /* Refill empty runs, if possible */
+    while (!run->size)
+    {
+        if (!run->refill || run->refill(run))
+        {
+            run->size = 0;
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static int bh_merge_beats(bh_merge_run_t *runs,
+                          size_t a,
+                          size_t b,
+                          bh_compare_cb_t compare)
+{
+    int result;
+
+    /* Finished runs always lose */
+    if (!runs[a].size)
+        return 0;
+    if (!runs[b].size)
+        return 1;
+
+    /* Equal elements are ordered by run index */
+    result = compare(runs[a].data, runs[b].data);
+    return result < 0 || (result == 0 && a < b);
+}
+
+int bh_merge_k(bh_merge_run_t *runs,
+               size_t nruns,
+               size_t element,
+               bh_compare_cb_t compare,
+               bh_merge_out_cb_t out,
+               void *data)
+{
+    size_t *tree, *winners, i, node, winner, tmp;
+    int result;
+
+    if (!nruns)
+        return 0;
+
+    if (nruns > ((size_t)-1) / (3 * sizeof(size_t)))
+        return -1;
+
+    /* Tree stores losers in internal nodes and the winner at index 0 */
+    tree = malloc(sizeof(size_t) * nruns * 3);
+    if (!tree)
+        return -1;
+    winners = tree + nruns;
+
+    for (i = 0; i < nruns; i++)
+    {
+        bh_merge_ready(runs + i);
+        winners[nruns + i] = i;
+    }
+
+    /* Play initial matches bottom up */
+    for (node = nruns - 1; node; node--)
+    {
+        if (bh_merge_beats(runs, winners[node * 2 + 1], winners[node * 2], compare))
+        {
+            winners[node] = winners[node * 2 + 1];
+            tree[node] = winners[node * 2];
+        }
+        else
+        {
+            winners[node] = winners[node * 2];
+            tree[node] = winners[node * 2 + 1];
+        }
+    }
+    tree[0] = (nruns > 1) ? (winners[1]) : (0);
+
+    result = 0;
+    while (runs[tree[0]].size)
+    {
+        /* Output winner and advance its run */
+        winner = tree[0];
+        result = out(runs[winner].data, data);
+        if (result)
+            break;
+
+        runs[winner].data = (const char *)runs[winner].data + element;
+        runs[winner].size--;
+        bh_merge_ready(runs + winner);
+
+        /* Replay matches on the path from the leaf to the root */
+        for (node = (winner + nruns) / 2; node; node /= 2)
+        {
+            if (bh_merge_beats(runs, tree[node], winner, compare))
+            {
+                tmp = tree[node];
+                tree[node] = winner;
+                winner = tmp;
+            }
+        }
+        tree[0] = winner;
+    }
+
+    free(tree);
+    return result;
+}
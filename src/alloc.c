@@ -0,0 +1,323 @@
+/*
+ * BHLib
+ *
+ * Copyright (c) 2024 Mikhail Romanko
+ */
+#include <bh/alloc.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+static void *bh_allocator_malloc(void *context,
+                                 size_t size)
+{
+    (void)context;
+    return malloc(size);
+}
+
+static void *bh_allocator_realloc(void *context,
+                                  void *ptr,
+                                  size_t old_size,
+                                  size_t size)
+{
+    (void)context;
+    (void)old_size;
+    return realloc(ptr, size);
+}
+
+static void bh_allocator_free(void *context,
+                              void *ptr,
+                              size_t size)
+{
+    (void)context;
+    (void)size;
+    free(ptr);
+}
+
+static const bh_allocator_t bh_allocator_libc =
+{
+    bh_allocator_malloc,
+    bh_allocator_realloc,
+    bh_allocator_free,
+    NULL
+};
+
+const bh_allocator_t *bh_allocator_default(void)
+{
+    return &bh_allocator_libc;
+}
+
+void *bh_alloc(const bh_allocator_t *allocator,
+               size_t size)
+{
+    if (!allocator)
+        allocator = &bh_allocator_libc;
+
+    return allocator->alloc(allocator->context, size);
+}
+
+void *bh_realloc(const bh_allocator_t *allocator,
+                 void *ptr,
+                 size_t old_size,
+                 size_t size)
+{
+    void *result;
+
+    if (!allocator)
+        allocator = &bh_allocator_libc;
+
+    if (allocator->realloc)
+        return allocator->realloc(allocator->context, ptr, old_size, size);
+
+    /* Emulate reallocation */
+    result = allocator->alloc(allocator->context, size);
+    if (!result)
+        return NULL;
+
+    if (ptr)
+    {
+        memcpy(result, ptr, (old_size < size) ? (old_size) : (size));
+        allocator->free(allocator->context, ptr, old_size);
+    }
+
+    return result;
+}
+
+void bh_free(const bh_allocator_t *allocator,
+             void *ptr,
+             size_t size)
+{
+    if (!ptr)
+        return;
+
+    if (!allocator)
+        allocator = &bh_allocator_libc;
+
+    allocator->free(allocator->context, ptr, size);
+}
+
+static int bh_arena_last(const bh_arena_t *arena,
+                         const void *ptr,
+                         size_t size)
+{
+    /* Check that memory is the last allocation in the current chunk */
+    return ptr && arena->chunk && (const char *)ptr >= (const char *)(arena->chunk + 1) &&
+           (const char *)ptr + size == arena->current;
+}
+
+static void *bh_arena_cb_alloc(void *context,
+                               size_t size)
+{
+    return bh_arena_alloc((bh_arena_t *)context, size);
+}
+
+static void *bh_arena_cb_realloc(void *context,
+                                 void *ptr,
+                                 size_t old_size,
+                                 size_t size)
+{
+    bh_arena_t *arena;
+    void *result;
+
+    arena = (bh_arena_t *)context;
+
+    /* Last allocation can be resized in-place */
+    if (bh_arena_last(arena, ptr, old_size) && size <= (size_t)(arena->end - (char *)ptr))
+    {
+        arena->current = (char *)ptr + size;
+        arena->stats.used = arena->stats.used - old_size + size;
+        if (arena->stats.used > arena->stats.peak)
+            arena->stats.peak = arena->stats.used;
+        return ptr;
+    }
+
+    result = bh_arena_alloc(arena, size);
+    if (result && ptr)
+        memcpy(result, ptr, (old_size < size) ? (old_size) : (size));
+
+    return result;
+}
+
+static void bh_arena_cb_free(void *context,
+                             void *ptr,
+                             size_t size)
+{
+    bh_arena_t *arena;
+
+    arena = (bh_arena_t *)context;
+
+    /* Only the last allocation can be freed */
+    if (bh_arena_last(arena, ptr, size))
+    {
+        arena->current = (char *)ptr;
+        arena->stats.used -= size;
+        arena->stats.count--;
+    }
+}
+
+static void bh_arena_release(bh_arena_t *arena,
+                             bh_arena_chunk_t *chunk)
+{
+    /* Keep the largest released chunk as a spare */
+    if (arena->spare && arena->spare->size >= chunk->size)
+    {
+        arena->stats.capacity -= chunk->size;
+        arena->stats.chunks--;
+        bh_free(arena->backing, chunk, chunk->size);
+        return;
+    }
+
+    if (arena->spare)
+    {
+        arena->stats.capacity -= arena->spare->size;
+        arena->stats.chunks--;
+        bh_free(arena->backing, arena->spare, arena->spare->size);
+    }
+    arena->spare = chunk;
+}
+
+static int bh_arena_grow(bh_arena_t *arena,
+                         size_t size,
+                         size_t align)
+{
+    bh_arena_chunk_t *chunk;
+    size_t need;
+
+    /* Chunk should fit header, padding and the allocation */
+    need = sizeof(bh_arena_chunk_t) + align - 1;
+    if (size > ((size_t)-1) - need)
+        return -1;
+    need += size;
+
+    if (arena->spare && arena->spare->size >= need)
+    {
+        chunk = arena->spare;
+        arena->spare = NULL;
+    }
+    else
+    {
+        if (need < arena->chunk_size)
+            need = arena->chunk_size;
+
+        chunk = (bh_arena_chunk_t *)bh_alloc(arena->backing, need);
+        if (!chunk)
+            return -1;
+
+        chunk->size = need;
+        arena->stats.capacity += need;
+        arena->stats.chunks++;
+    }
+
+    chunk->prev = arena->chunk;
+    arena->chunk = chunk;
+    arena->current = (char *)(chunk + 1);
+    arena->end = (char *)chunk + chunk->size;
+    return 0;
+}
+
+void bh_arena_init(bh_arena_t *arena,
+                   size_t chunk_size,
+                   const bh_allocator_t *backing)
+{
+    memset(arena, 0, sizeof(*arena));
+    arena->chunk_size = (chunk_size) ? (chunk_size) : (BH_ARENA_CHUNK);
+    arena->backing = backing;
+    arena->allocator.alloc = bh_arena_cb_alloc;
+    arena->allocator.realloc = bh_arena_cb_realloc;
+    arena->allocator.free = bh_arena_cb_free;
+    arena->allocator.context = arena;
+}
+
+void bh_arena_destroy(bh_arena_t *arena)
+{
+    bh_arena_chunk_t *chunk;
+
+    while (arena->chunk)
+    {
+        chunk = arena->chunk;
+        arena->chunk = chunk->prev;
+        bh_free(arena->backing, chunk, chunk->size);
+    }
+
+    if (arena->spare)
+        bh_free(arena->backing, arena->spare, arena->spare->size);
+}
+
+void *bh_arena_alloc(bh_arena_t *arena,
+                     size_t size)
+{
+    return bh_arena_alloc_aligned(arena, size, BH_ARENA_ALIGN);
+}
+
+void *bh_arena_alloc_aligned(bh_arena_t *arena,
+                             size_t size,
+                             size_t align)
+{
+    char *result;
+    size_t padding;
+
+    if (!align || (align & (align - 1)))
+        return NULL;
+
+    /* Find aligned position in the current chunk or start new chunk */
+    padding = (align - (size_t)((uintptr_t)arena->current & (align - 1))) & (align - 1);
+    if (!arena->current || padding > (size_t)(arena->end - arena->current) ||
+        size > (size_t)(arena->end - arena->current) - padding)
+    {
+        if (bh_arena_grow(arena, size, align))
+            return NULL;
+        padding = (align - (size_t)((uintptr_t)arena->current & (align - 1))) & (align - 1);
+    }
+
+    result = arena->current + padding;
+    arena->current = result + size;
+
+    /* Update statistics */
+    arena->stats.count++;
+    arena->stats.used += padding + size;
+    if (arena->stats.used > arena->stats.peak)
+        arena->stats.peak = arena->stats.used;
+
+    return result;
+}
+
+void bh_arena_mark(const bh_arena_t *arena,
+                   bh_arena_mark_t *mark)
+{
+    mark->chunk = arena->chunk;
+    mark->current = arena->current;
+    mark->count = arena->stats.count;
+    mark->used = arena->stats.used;
+}
+
+void bh_arena_reset_to(bh_arena_t *arena,
+                       const bh_arena_mark_t *mark)
+{
+    bh_arena_chunk_t *chunk;
+
+    /* Release chunks allocated after the mark */
+    while (arena->chunk && arena->chunk != mark->chunk)
+    {
+        chunk = arena->chunk;
+        arena->chunk = chunk->prev;
+        bh_arena_release(arena, chunk);
+    }
+
+    arena->current = mark->current;
+    arena->end = (arena->chunk) ? ((char *)arena->chunk + arena->chunk->size) : (NULL);
+    arena->stats.count = mark->count;
+    arena->stats.used = mark->used;
+}
+
+void bh_arena_reset(bh_arena_t *arena)
+{
+    bh_arena_mark_t mark;
+
+    memset(&mark, 0, sizeof(mark));
+    bh_arena_reset_to(arena, &mark);
+}
+
+const bh_allocator_t *bh_arena_allocator(bh_arena_t *arena)
+{
+    return &arena->allocator;
+}
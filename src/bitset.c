@@ -0,0 +1,504 @@
+/*
+ * BHLib
+ *
+ * Copyright (c) 2024 Mikhail Romanko
+ */
+#include <bh/ds.h>
+#include <string.h>
+#include <stdint.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BH_BITSET_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(BH_BITSET_SSE2) && defined(__AVX2__)
+#define BH_BITSET_AVX2
+#define BH_BITSET_AVX2_TARGET
+#include <immintrin.h>
+#elif defined(BH_BITSET_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BH_BITSET_AVX2
+#define BH_BITSET_DISPATCH
+#define BH_BITSET_AVX2_TARGET __attribute__((target("avx2")))
+#define BH_BITSET_POPCNT_TARGET __attribute__((target("popcnt")))
+#include <immintrin.h>
+#endif
+
+#define BH_BITSET_WORD      64
+#define BH_BITSET_BLOCK     64
+
+#define BH_BITSET_WORDS(size) \
+    (((size) + BH_BITSET_WORD - 1) / BH_BITSET_WORD)
+
+typedef void (*bh_bitset_op_cb_t)(uint64_t *, const uint64_t *, size_t);
+typedef size_t (*bh_bitset_count_cb_t)(const uint64_t *, size_t);
+
+typedef struct
+{
+    bh_bitset_count_cb_t count;
+    bh_bitset_op_cb_t op[4];
+} bh_bitset_kernel_t;
+
+enum
+{
+    BH_BITSET_AND,
+    BH_BITSET_OR,
+    BH_BITSET_XOR,
+    BH_BITSET_ANDNOT
+};
+
+static BH_INLINE size_t bh_bitset_popcount(uint64_t word)
+{
+#if defined(__GNUC__)
+    return (size_t)__builtin_popcountll(word);
+#else
+    word = word - ((word >> 1) & 0x5555555555555555ull);
+    word = (word & 0x3333333333333333ull) + ((word >> 2) & 0x3333333333333333ull);
+    word = (word + (word >> 4)) & 0x0f0f0f0f0f0f0f0full;
+    return (size_t)((word * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+static BH_INLINE size_t bh_bitset_ctz(uint64_t word)
+{
+#if defined(__GNUC__)
+    return (size_t)__builtin_ctzll(word);
+#else
+    size_t result;
+
+    for (result = 0; !(word & 1); word >>= 1)
+        result++;
+    return result;
+#endif
+}
+
+/* Scalar kernels, used for tails and platforms without SIMD */
+static size_t bh_bitset_count_scalar(const uint64_t *data,
+                                     size_t size)
+{
+    size_t i, result;
+
+    for (i = 0, result = 0; i < size; i++)
+        result += bh_bitset_popcount(data[i]);
+
+    return result;
+}
+
+#define BH_BITSET_SCALAR_DEFINE(name, expr)                                     \
+static void name(uint64_t *dst,                                                 \
+                 const uint64_t *src,                                           \
+                 size_t size)                                                   \
+{                                                                               \
+    uint64_t x, y;                                                              \
+    size_t i;                                                                   \
+                                                                                \
+    for (i = 0; i < size; i++)                                                  \
+    {                                                                           \
+        x = dst[i];                                                             \
+        y = src[i];                                                             \
+        dst[i] = (expr);                                                        \
+    }                                                                           \
+}
+
+BH_BITSET_SCALAR_DEFINE(bh_bitset_and_scalar, x & y)
+BH_BITSET_SCALAR_DEFINE(bh_bitset_or_scalar, x | y)
+BH_BITSET_SCALAR_DEFINE(bh_bitset_xor_scalar, x ^ y)
+BH_BITSET_SCALAR_DEFINE(bh_bitset_andnot_scalar, x & ~y)
+
+#if !defined(BH_BITSET_SSE2)
+static const bh_bitset_kernel_t bh_bitset_scalar =
+{
+    bh_bitset_count_scalar,
+    {
+        bh_bitset_and_scalar,
+        bh_bitset_or_scalar,
+        bh_bitset_xor_scalar,
+        bh_bitset_andnot_scalar
+    }
+};
+#endif
+
+/*
+ * Vector kernels process whole vectors, remaining tail is processed by the
+ * scalar kernel.
+ */
+#define BH_BITSET_KERNEL_DEFINE(name, attr, vec, load, store, expr, tail)       \
+static attr void name(uint64_t *dst,                                            \
+                      const uint64_t *src,                                      \
+                      size_t size)                                              \
+{                                                                               \
+    size_t i, step;                                                             \
+    vec x, y;                                                                   \
+                                                                                \
+    step = sizeof(vec) / sizeof(uint64_t);                                      \
+    for (i = 0; i + step <= size; i += step)                                    \
+    {                                                                           \
+        x = load((const vec *)(dst + i));                                       \
+        y = load((const vec *)(src + i));                                       \
+        store((vec *)(dst + i), expr);                                          \
+    }                                                                           \
+    tail(dst + i, src + i, size - i);                                           \
+}
+
+#if defined(BH_BITSET_SSE2) && (!defined(BH_BITSET_AVX2) || defined(BH_BITSET_DISPATCH))
+BH_BITSET_KERNEL_DEFINE(bh_bitset_and_sse2, , __m128i, _mm_loadu_si128, _mm_storeu_si128, _mm_and_si128(x, y), bh_bitset_and_scalar)
+BH_BITSET_KERNEL_DEFINE(bh_bitset_or_sse2, , __m128i, _mm_loadu_si128, _mm_storeu_si128, _mm_or_si128(x, y), bh_bitset_or_scalar)
+BH_BITSET_KERNEL_DEFINE(bh_bitset_xor_sse2, , __m128i, _mm_loadu_si128, _mm_storeu_si128, _mm_xor_si128(x, y), bh_bitset_xor_scalar)
+BH_BITSET_KERNEL_DEFINE(bh_bitset_andnot_sse2, , __m128i, _mm_loadu_si128, _mm_storeu_si128, _mm_andnot_si128(y, x), bh_bitset_andnot_scalar)
+
+static const bh_bitset_kernel_t bh_bitset_sse2 =
+{
+    bh_bitset_count_scalar,
+    {
+        bh_bitset_and_sse2,
+        bh_bitset_or_sse2,
+        bh_bitset_xor_sse2,
+        bh_bitset_andnot_sse2
+    }
+};
+#endif
+
+#if defined(BH_BITSET_DISPATCH)
+static BH_BITSET_POPCNT_TARGET size_t bh_bitset_count_popcnt(const uint64_t *data,
+                                                             size_t size)
+{
+    size_t i, result;
+
+    for (i = 0, result = 0; i < size; i++)
+        result += (size_t)__builtin_popcountll(data[i]);
+
+    return result;
+}
+
+static const bh_bitset_kernel_t bh_bitset_popcnt =
+{
+    bh_bitset_count_popcnt,
+    {
+        bh_bitset_and_sse2,
+        bh_bitset_or_sse2,
+        bh_bitset_xor_sse2,
+        bh_bitset_andnot_sse2
+    }
+};
+#endif
+
+#if defined(BH_BITSET_AVX2)
+static BH_BITSET_AVX2_TARGET size_t bh_bitset_count_avx2(const uint64_t *data,
+                                                         size_t size)
+{
+    __m256i lookup, low, total, sum, value;
+    uint64_t lanes[4];
+    size_t i;
+
+    /* Nibble lookup with byte sums accumulated into 64-bit lanes */
+    lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                              0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    low = _mm256_set1_epi8(0x0f);
+    total = _mm256_setzero_si256();
+
+    for (i = 0; i + 4 <= size; i += 4)
+    {
+        value = _mm256_loadu_si256((const __m256i *)(data + i));
+        sum = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, _mm256_and_si256(value, low)),
+                              _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(value, 4), low)));
+        total = _mm256_add_epi64(total, _mm256_sad_epu8(sum, _mm256_setzero_si256()));
+    }
+
+    _mm256_storeu_si256((__m256i *)lanes, total);
+    return (size_t)(lanes[0] + lanes[1] + lanes[2] + lanes[3]) +
+           bh_bitset_count_scalar(data + i, size - i);
+}
+
+BH_BITSET_KERNEL_DEFINE(bh_bitset_and_avx2, BH_BITSET_AVX2_TARGET, __m256i, _mm256_loadu_si256, _mm256_storeu_si256, _mm256_and_si256(x, y), bh_bitset_and_scalar)
+BH_BITSET_KERNEL_DEFINE(bh_bitset_or_avx2, BH_BITSET_AVX2_TARGET, __m256i, _mm256_loadu_si256, _mm256_storeu_si256, _mm256_or_si256(x, y), bh_bitset_or_scalar)
+BH_BITSET_KERNEL_DEFINE(bh_bitset_xor_avx2, BH_BITSET_AVX2_TARGET, __m256i, _mm256_loadu_si256, _mm256_storeu_si256, _mm256_xor_si256(x, y), bh_bitset_xor_scalar)
+BH_BITSET_KERNEL_DEFINE(bh_bitset_andnot_avx2, BH_BITSET_AVX2_TARGET, __m256i, _mm256_loadu_si256, _mm256_storeu_si256, _mm256_andnot_si256(y, x), bh_bitset_andnot_scalar)
+
+static const bh_bitset_kernel_t bh_bitset_avx2 =
+{
+    bh_bitset_count_avx2,
+    {
+        bh_bitset_and_avx2,
+        bh_bitset_or_avx2,
+        bh_bitset_xor_avx2,
+        bh_bitset_andnot_avx2
+    }
+};
+#endif
+
+static const bh_bitset_kernel_t *bh_bitset_kernel(void)
+{
+#if defined(BH_BITSET_DISPATCH)
+    static const bh_bitset_kernel_t *kernel = NULL;
+
+    /* Check CPU features once, races are harmless (same value is stored) */
+    if (!kernel)
+    {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            kernel = &bh_bitset_avx2;
+        else if (__builtin_cpu_supports("popcnt"))
+            kernel = &bh_bitset_popcnt;
+        else
+            kernel = &bh_bitset_sse2;
+    }
+    return kernel;
+#elif defined(BH_BITSET_AVX2)
+    return &bh_bitset_avx2;
+#elif defined(BH_BITSET_SSE2)
+    return &bh_bitset_sse2;
+#else
+    return &bh_bitset_scalar;
+#endif
+}
+
+static void bh_bitset_trim(bh_bitset_t *bitset)
+{
+    uint64_t *data;
+    size_t bits;
+
+    /* Bits past the size are kept cleared */
+    data = (uint64_t *)bitset->data;
+    bits = bitset->size % BH_BITSET_WORD;
+    if (bits)
+        data[bitset->size / BH_BITSET_WORD] &= ((uint64_t)1 << bits) - 1;
+}
+
+static int bh_bitset_op(bh_bitset_t *bitset,
+                        const bh_bitset_t *other,
+                        int op)
+{
+    if (bitset->size != other->size)
+        return -1;
+
+    bh_bitset_kernel()->op[op]((uint64_t *)bitset->data,
+                               (const uint64_t *)other->data,
+                               BH_BITSET_WORDS(bitset->size));
+    return 0;
+}
+
+void bh_bitset_init(bh_bitset_t *bitset)
+{
+    bh_bitset_init_alloc(bitset, NULL);
+}
+
+void bh_bitset_init_alloc(bh_bitset_t *bitset,
+                          const bh_allocator_t *allocator)
+{
+    memset(bitset, 0, sizeof(*bitset));
+    bitset->allocator = (allocator) ? (allocator) : (bh_allocator_default());
+}
+
+void bh_bitset_destroy(bh_bitset_t *bitset)
+{
+    bh_free(bitset->allocator, bitset->data, bitset->capacity * sizeof(uint64_t));
+}
+
+void bh_bitset_clear(bh_bitset_t *bitset)
+{
+    bitset->size = 0;
+}
+
+int bh_bitset_reserve(bh_bitset_t *bitset,
+                      size_t size)
+{
+    size_t capacity;
+    void *data;
+
+    /* Requested capacity should be in range [bitset->size; max_capacity] */
+    if (size < bitset->size)
+        size = bitset->size;
+
+    capacity = BH_BITSET_WORDS(size);
+    if (size > ((size_t)-1) - BH_BITSET_WORD || capacity > ((size_t)-1) / sizeof(uint64_t))
+        return -1;
+
+    /* Prevent same size reallocation */
+    if (capacity == bitset->capacity)
+        return 0;
+
+    if (capacity)
+    {
+        data = bh_realloc(bitset->allocator, bitset->data,
+                          bitset->capacity * sizeof(uint64_t), capacity * sizeof(uint64_t));
+        if (!data)
+            return -1;
+    }
+    else
+    {
+        bh_free(bitset->allocator, bitset->data, bitset->capacity * sizeof(uint64_t));
+        data = NULL;
+    }
+
+    bitset->data = data;
+    bitset->capacity = capacity;
+    return 0;
+}
+
+int bh_bitset_resize(bh_bitset_t *bitset,
+                     size_t size)
+{
+    size_t from, to;
+
+    if (BH_BITSET_WORDS(size) > bitset->capacity)
+        if (bh_bitset_reserve(bitset, size))
+            return -1;
+
+    /* Clear new words (tail of the last word is already cleared) */
+    if (size > bitset->size)
+    {
+        from = BH_BITSET_WORDS(bitset->size);
+        to = BH_BITSET_WORDS(size);
+        if (to > from)
+            memset((uint64_t *)bitset->data + from, 0, (to - from) * sizeof(uint64_t));
+    }
+
+    bitset->size = size;
+    if (size)
+        bh_bitset_trim(bitset);
+
+    return 0;
+}
+
+void bh_bitset_set(bh_bitset_t *bitset,
+                   size_t index)
+{
+    ((uint64_t *)bitset->data)[index / BH_BITSET_WORD] |= (uint64_t)1 << (index % BH_BITSET_WORD);
+}
+
+void bh_bitset_reset(bh_bitset_t *bitset,
+                     size_t index)
+{
+    ((uint64_t *)bitset->data)[index / BH_BITSET_WORD] &= ~((uint64_t)1 << (index % BH_BITSET_WORD));
+}
+
+int bh_bitset_test(const bh_bitset_t *bitset,
+                   size_t index)
+{
+    return (((const uint64_t *)bitset->data)[index / BH_BITSET_WORD] >> (index % BH_BITSET_WORD)) & 1;
+}
+
+void bh_bitset_fill(bh_bitset_t *bitset,
+                    int value)
+{
+    if (!bitset->size)
+        return;
+
+    memset(bitset->data, (value) ? (0xff) : (0), BH_BITSET_WORDS(bitset->size) * sizeof(uint64_t));
+    bh_bitset_trim(bitset);
+}
+
+size_t bh_bitset_count(const bh_bitset_t *bitset)
+{
+    return bh_bitset_kernel()->count((const uint64_t *)bitset->data,
+                                     BH_BITSET_WORDS(bitset->size));
+}
+
+size_t bh_bitset_next(const bh_bitset_t *bitset,
+                      size_t index)
+{
+    const uint64_t *data;
+    size_t i, words;
+    uint64_t word;
+
+    if (index >= bitset->size)
+        return bitset->size;
+
+    /* Mask bits before the index in the first word */
+    data = (const uint64_t *)bitset->data;
+    words = BH_BITSET_WORDS(bitset->size);
+    i = index / BH_BITSET_WORD;
+    word = data[i] & (~(uint64_t)0 << (index % BH_BITSET_WORD));
+
+    while (!word)
+    {
+        if (++i >= words)
+            return bitset->size;
+        word = data[i];
+    }
+
+    return i * BH_BITSET_WORD + bh_bitset_ctz(word);
+}
+
+size_t bh_bitset_rank(const bh_bitset_t *bitset,
+                      size_t index)
+{
+    const uint64_t *data;
+    size_t result, bits;
+
+    if (index > bitset->size)
+        index = bitset->size;
+
+    data = (const uint64_t *)bitset->data;
+    result = bh_bitset_kernel()->count(data, index / BH_BITSET_WORD);
+
+    bits = index % BH_BITSET_WORD;
+    if (bits)
+        result += bh_bitset_popcount(data[index / BH_BITSET_WORD] & (((uint64_t)1 << bits) - 1));
+
+    return result;
+}
+
+size_t bh_bitset_select(const bh_bitset_t *bitset,
+                        size_t rank)
+{
+    const bh_bitset_kernel_t *kernel;
+    const uint64_t *data;
+    size_t i, words, count;
+    uint64_t word;
+
+    kernel = bh_bitset_kernel();
+    data = (const uint64_t *)bitset->data;
+    words = BH_BITSET_WORDS(bitset->size);
+
+    /* Skip whole blocks with vector popcount, then scan words */
+    for (i = 0; i + BH_BITSET_BLOCK <= words; i += BH_BITSET_BLOCK)
+    {
+        count = kernel->count(data + i, BH_BITSET_BLOCK);
+        if (count > rank)
+            break;
+        rank -= count;
+    }
+
+    for (; i < words; i++)
+    {
+        count = bh_bitset_popcount(data[i]);
+        if (count > rank)
+            break;
+        rank -= count;
+    }
+
+    if (i >= words)
+        return bitset->size;
+
+    /* Drop lowest set bits until requested one is the lowest */
+    word = data[i];
+    while (rank--)
+        word &= word - 1;
+
+    return i * BH_BITSET_WORD + bh_bitset_ctz(word);
+}
+
+int bh_bitset_and(bh_bitset_t *bitset,
+                  const bh_bitset_t *other)
+{
+    return bh_bitset_op(bitset, other, BH_BITSET_AND);
+}
+
+int bh_bitset_or(bh_bitset_t *bitset,
+                 const bh_bitset_t *other)
+{
+    return bh_bitset_op(bitset, other, BH_BITSET_OR);
+}
+
+int bh_bitset_xor(bh_bitset_t *bitset,
+                  const bh_bitset_t *other)
+{
+    return bh_bitset_op(bitset, other, BH_BITSET_XOR);
+}
+
+int bh_bitset_andnot(bh_bitset_t *bitset,
+                     const bh_bitset_t *other)
+{
+    return bh_bitset_op(bitset, other, BH_BITSET_ANDNOT);
+}
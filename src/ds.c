@@ -8,17 +8,47 @@
 #include <string.h>
 #include <stdlib.h>
 
+static size_t bh_grow(size_t capacity,
+                      size_t required,
+                      size_t growth)
+{
+    /* Fallback to default growth factor if it's not set or invalid */
+    if (growth <= 100)
+        growth = BH_GROWTH_DEFAULT;
+
+    /* Calculate new capacity (percents), prevent overflow */
+    if (capacity / 100 < ((size_t)-1) / growth)
+        capacity = capacity / 100 * growth + capacity % 100 * growth / 100;
+    else
+        capacity = required;
+
+    if (capacity < BH_GROWTH_MIN)
+        capacity = BH_GROWTH_MIN;
+    if (capacity < required)
+        capacity = required;
+
+    return capacity;
+}
+
 void bh_array_init(bh_array_t *array,
                    size_t element)
+{
+    bh_array_init_alloc(array, element, NULL);
+}
+
+void bh_array_init_alloc(bh_array_t *array,
+                         size_t element,
+                         const bh_allocator_t *allocator)
 {
     memset(array, 0, sizeof(*array));
     array->element = element;
+    array->growth = BH_GROWTH_DEFAULT;
+    array->allocator = (allocator) ? (allocator) : (bh_allocator_default());
 }
 
 void bh_array_destroy(bh_array_t *array)
 {
-    if (array->data)
-        free(array->data);
+    bh_free(array->allocator, array->data, array->capacity * array->element);
 }
 
 void bh_array_clear(bh_array_t *array)
@@ -44,25 +74,32 @@ int bh_array_reserve(bh_array_t *array,
     if (capacity == array->capacity)
         return 0;
 
-    /* Allocate and copy data */
-    data = NULL;
+    /* Reallocate data (large blocks can be remapped without copying) */
     if (capacity)
     {
-        data = malloc(array->element * capacity);
+        data = bh_realloc(array->allocator, array->data,
+                          array->element * array->capacity, array->element * capacity);
         if (!data)
             return -1;
-        if (array->size)
-            memmove(data, array->data, array->size * array->element);
+    }
+    else
+    {
+        bh_free(array->allocator, array->data, array->element * array->capacity);
+        data = NULL;
     }
 
     /* Update array fields */
-    if (array->data)
-        free(array->data);
     array->data = data;
     array->capacity = capacity;
     return 0;
 }
 
+void bh_array_set_growth(bh_array_t *array,
+                         size_t growth)
+{
+    array->growth = growth;
+}
+
 int bh_array_resize(bh_array_t *array,
                     size_t size)
 {
@@ -76,18 +113,25 @@ int bh_array_resize(bh_array_t *array,
 
 void *bh_array_insert(bh_array_t *array,
                       size_t index)
+{
+    return bh_array_insert_n(array, index, 1);
+}
+
+void *bh_array_insert_n(bh_array_t *array,
+                        size_t index,
+                        size_t count)
 {
     size_t move_size;
     char *from, *to;
 
     /* Check array capacity */
-    if (array->capacity < array->size + 1)
+    if (array->capacity < array->size + count)
     {
         size_t capacity;
 
         /* Check potential size overflow and reserve capacity */
-        capacity = (array->size) ? (array->size * 2) : (16);
-        if (capacity < array->size || bh_array_reserve(array, capacity))
+        capacity = bh_grow(array->capacity, array->size + count, array->growth);
+        if (array->size + count < array->size || bh_array_reserve(array, capacity))
             return NULL;
     }
 
@@ -97,14 +141,72 @@ void *bh_array_insert(bh_array_t *array,
     /* Shift data to the right */
     move_size = (array->size - index) * array->element;
     from = (char *)array->data + index * array->element;
-    to = from + array->element;
-    memmove(to, from, move_size);
+    to = from + count * array->element;
+    if (move_size && count)
+        memmove(to, from, move_size);
 
     /* Update array fields and return iterator */
-    array->size++;
+    array->size += count;
     return from;
 }
 
+int bh_array_append(bh_array_t *array,
+                    const void *src,
+                    size_t count)
+{
+    size_t offset;
+    char *data, *to;
+
+    if (!count)
+        return 0;
+
+    /* Source can point into the array, which can be reallocated */
+    data = (char *)array->data;
+    offset = (size_t)-1;
+    if (data && (const char *)src >= data && (const char *)src < data + array->size * array->element)
+        offset = (const char *)src - data;
+
+    to = bh_array_insert_n(array, array->size, count);
+    if (!to)
+        return -1;
+
+    if (offset != (size_t)-1)
+        src = (char *)array->data + offset;
+
+    memcpy(to, src, count * array->element);
+    return 0;
+}
+
+void *bh_array_erase_range(bh_array_t *array,
+                           void *first,
+                           void *last)
+{
+    size_t index, count, move_size;
+    char *end;
+
+    /* Iterators should be valid */
+    end = (char *)array->data + array->size * array->element;
+    if ((char *)last > end)
+        last = end;
+
+    index = ((char *)first - (char *)array->data) / array->element;
+    if (index >= array->size || (char *)last < (char *)first)
+        return NULL;
+
+    /* Shift data to the left */
+    count = ((char *)last - (char *)first) / array->element;
+    move_size = end - (char *)last;
+    if (move_size && count)
+        memmove(first, last, move_size);
+
+    /* Update array fields and return iterator */
+    array->size -= count;
+    if (index >= array->size)
+        return NULL;
+
+    return first;
+}
+
 void *bh_array_at(bh_array_t *array,
                   size_t index)
 {
@@ -122,43 +224,651 @@ void *bh_array_remove(bh_array_t *array,
     if (index >= array->size)
         return NULL;
 
-    /* Shift data to the left */
-    move_size = (array->size - index - 1) * array->element;
-    to = (char *)array->data + index * array->element;
-    from = to + array->element;
-    memmove(to, from, move_size);
+    /* Shift data to the left */
+    move_size = (array->size - index - 1) * array->element;
+    to = (char *)array->data + index * array->element;
+    from = to + array->element;
+    memmove(to, from, move_size);
+
+    /* Update array fields and return iterator */
+    array->size--;
+    if (index >= array->size)
+        return NULL;
+
+    return iter;
+}
+
+size_t bh_array_remove_if(bh_array_t *array,
+                          bh_predicate_cb_t predicate,
+                          void *data)
+{
+    char *current, *end, *run, *to;
+    size_t removed;
+
+    current = (char *)array->data;
+    end = current + array->size * array->element;
+    run = current;
+    to = current;
+
+    for (; current < end; current += array->element)
+    {
+        if (!predicate(current, data))
+            continue;
+
+        /* Move run of remaining elements before removed element */
+        if (to != run)
+            memmove(to, run, current - run);
+        to += current - run;
+        run = current + array->element;
+    }
+
+    /* Move last run */
+    if (to != run)
+        memmove(to, run, end - run);
+    to += end - run;
+
+    removed = array->size - (to - (char *)array->data) / array->element;
+    array->size -= removed;
+    return removed;
+}
+
+void *bh_array_next(bh_array_t *array,
+                    void *iter)
+{
+    char *item = (char *)iter;
+
+    /* Advance or set iterator */
+    if (item)
+        item += array->element;
+    else
+        item = array->data;
+
+    /* Check iterator for validity */
+    if (item >= (char *)array->data + array->size * array->element)
+        return NULL;
+
+    return item;
+}
+
+void *bh_array_value(bh_array_t *array,
+                     void *iter)
+{
+    (void)array;
+    return iter;
+}
+
+void bh_sarray_init(bh_sarray_t *array,
+                    size_t element,
+                    void *buffer,
+                    size_t capacity)
+{
+    bh_sarray_init_alloc(array, element, buffer, capacity, NULL);
+}
+
+void bh_sarray_init_alloc(bh_sarray_t *array,
+                          size_t element,
+                          void *buffer,
+                          size_t capacity,
+                          const bh_allocator_t *allocator)
+{
+    bh_array_init_alloc(&array->base, element, allocator);
+    array->buffer = buffer;
+    array->fixed = (buffer) ? (capacity) : (0);
+    array->base.data = array->buffer;
+    array->base.capacity = array->fixed;
+}
+
+void bh_sarray_destroy(bh_sarray_t *array)
+{
+    if (array->base.data != array->buffer)
+        bh_free(array->base.allocator, array->base.data, array->base.capacity * array->base.element);
+}
+
+void bh_sarray_clear(bh_sarray_t *array)
+{
+    array->base.size = 0;
+}
+
+int bh_sarray_reserve(bh_sarray_t *array,
+                      size_t size)
+{
+    void *data;
+    size_t capacity, element;
+
+    /* Requested capacity should be in range [array->size; max_capacity] */
+    element = array->base.element;
+    capacity = size;
+    if (capacity < array->base.size)
+        capacity = array->base.size;
+
+    if (capacity > ((size_t)-1) / element)
+        return -1;
+
+    /* Elements fit into the inline buffer - move them back */
+    if (capacity <= array->fixed)
+    {
+        if (array->base.data != array->buffer)
+        {
+            memcpy(array->buffer, array->base.data, array->base.size * element);
+            bh_free(array->base.allocator, array->base.data, array->base.capacity * element);
+            array->base.data = array->buffer;
+            array->base.capacity = array->fixed;
+        }
+        return 0;
+    }
+
+    /* Prevent same size reallocation */
+    if (capacity == array->base.capacity)
+        return 0;
+
+    /* Spill from the inline buffer or reallocate heap memory */
+    if (array->base.data == array->buffer)
+    {
+        data = bh_alloc(array->base.allocator, capacity * element);
+        if (!data)
+            return -1;
+        memcpy(data, array->buffer, array->base.size * element);
+    }
+    else
+    {
+        data = bh_realloc(array->base.allocator, array->base.data,
+                          array->base.capacity * element, capacity * element);
+        if (!data)
+            return -1;
+    }
+
+    array->base.data = data;
+    array->base.capacity = capacity;
+    return 0;
+}
+
+void bh_sarray_set_growth(bh_sarray_t *array,
+                          size_t growth)
+{
+    array->base.growth = growth;
+}
+
+int bh_sarray_resize(bh_sarray_t *array,
+                     size_t size)
+{
+    if (size > array->base.capacity)
+        if (bh_sarray_reserve(array, size))
+            return -1;
+
+    array->base.size = size;
+    return 0;
+}
+
+void *bh_sarray_insert(bh_sarray_t *array,
+                       size_t index)
+{
+    return bh_sarray_insert_n(array, index, 1);
+}
+
+void *bh_sarray_insert_n(bh_sarray_t *array,
+                         size_t index,
+                         size_t count)
+{
+    size_t capacity, size;
+
+    /* Reserve capacity here, array insert will only shift the data */
+    size = array->base.size;
+    if (array->base.capacity < size + count)
+    {
+        capacity = bh_grow(array->base.capacity, size + count, array->base.growth);
+        if (size + count < size || bh_sarray_reserve(array, capacity))
+            return NULL;
+    }
+
+    return bh_array_insert_n(&array->base, index, count);
+}
+
+int bh_sarray_append(bh_sarray_t *array,
+                     const void *src,
+                     size_t count)
+{
+    size_t capacity, size, offset;
+    char *data;
+
+    if (!count)
+        return 0;
+
+    /* Source can point into the array, which can be moved */
+    data = (char *)array->base.data;
+    size = array->base.size;
+    offset = (size_t)-1;
+    if (data && (const char *)src >= data && (const char *)src < data + size * array->base.element)
+        offset = (const char *)src - data;
+
+    /* Reserve capacity here, array append will only copy the data */
+    if (array->base.capacity < size + count)
+    {
+        capacity = bh_grow(array->base.capacity, size + count, array->base.growth);
+        if (size + count < size || bh_sarray_reserve(array, capacity))
+            return -1;
+    }
+
+    if (offset != (size_t)-1)
+        src = (char *)array->base.data + offset;
+
+    return bh_array_append(&array->base, src, count);
+}
+
+void *bh_sarray_erase_range(bh_sarray_t *array,
+                            void *first,
+                            void *last)
+{
+    return bh_array_erase_range(&array->base, first, last);
+}
+
+void *bh_sarray_at(bh_sarray_t *array,
+                   size_t index)
+{
+    return bh_array_at(&array->base, index);
+}
+
+void *bh_sarray_remove(bh_sarray_t *array,
+                       void *iter)
+{
+    return bh_array_remove(&array->base, iter);
+}
+
+size_t bh_sarray_remove_if(bh_sarray_t *array,
+                           bh_predicate_cb_t predicate,
+                           void *data)
+{
+    return bh_array_remove_if(&array->base, predicate, data);
+}
+
+void *bh_sarray_next(bh_sarray_t *array,
+                     void *iter)
+{
+    return bh_array_next(&array->base, iter);
+}
+
+void *bh_sarray_value(bh_sarray_t *array,
+                      void *iter)
+{
+    return bh_array_value(&array->base, iter);
+}
+
+static size_t bh_segarray_log2(size_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return sizeof(unsigned long long) * 8 - 1 - __builtin_clzll((unsigned long long)value);
+#else
+    size_t result;
+
+    for (result = 0; value >>= 1; result++);
+    return result;
+#endif
+}
+
+static void *bh_segarray_locate(bh_segarray_t *array,
+                                size_t index,
+                                size_t *count)
+{
+    size_t value, segment, offset;
+
+    /* Segment k starts at index 2^(k + shift) - 2^shift */
+    value = index + ((size_t)1 << BH_SEGARRAY_SHIFT);
+    segment = bh_segarray_log2(value);
+    offset = value - ((size_t)1 << segment);
+    segment -= BH_SEGARRAY_SHIFT;
+
+    if (count)
+        *count = ((size_t)1 << (segment + BH_SEGARRAY_SHIFT)) - offset;
+
+    return (char *)array->segments[segment] + offset * array->element;
+}
+
+void bh_segarray_init(bh_segarray_t *array,
+                      size_t element)
+{
+    bh_segarray_init_alloc(array, element, NULL);
+}
+
+void bh_segarray_init_alloc(bh_segarray_t *array,
+                            size_t element,
+                            const bh_allocator_t *allocator)
+{
+    memset(array, 0, sizeof(*array));
+    array->element = element;
+    array->allocator = (allocator) ? (allocator) : (bh_allocator_default());
+}
+
+void bh_segarray_destroy(bh_segarray_t *array)
+{
+    bh_segarray_clear(array);
+    bh_segarray_reserve(array, 0);
+}
+
+void bh_segarray_clear(bh_segarray_t *array)
+{
+    array->size = 0;
+}
+
+int bh_segarray_reserve(bh_segarray_t *array,
+                        size_t size)
+{
+    size_t capacity, length;
+    void *segment;
+
+    /* Requested capacity should be at least array->size */
+    capacity = size;
+    if (capacity < array->size)
+        capacity = array->size;
+
+    /* Allocate new segments, existing elements are never moved */
+    while (array->capacity < capacity)
+    {
+        if (array->count >= BH_SEGARRAY_SEGMENTS)
+            return -1;
+
+        length = (size_t)1 << (array->count + BH_SEGARRAY_SHIFT);
+        if (length > ((size_t)-1) / array->element)
+            return -1;
+
+        segment = bh_alloc(array->allocator, length * array->element);
+        if (!segment)
+            return -1;
+
+        array->segments[array->count++] = segment;
+        array->capacity += length;
+    }
+
+    /* Free trailing segments, that are not needed */
+    while (array->count)
+    {
+        length = (size_t)1 << (array->count - 1 + BH_SEGARRAY_SHIFT);
+        if (array->capacity - length < capacity)
+            break;
+
+        array->count--;
+        bh_free(array->allocator, array->segments[array->count], length * array->element);
+        array->segments[array->count] = NULL;
+        array->capacity -= length;
+    }
+
+    return 0;
+}
+
+int bh_segarray_resize(bh_segarray_t *array,
+                       size_t size)
+{
+    if (size > array->capacity)
+        if (bh_segarray_reserve(array, size))
+            return -1;
+
+    array->size = size;
+    return 0;
+}
+
+void *bh_segarray_push_back(bh_segarray_t *array)
+{
+    /* Reserve adds single segment, which doubles the capacity */
+    if (array->size == array->capacity)
+        if (bh_segarray_reserve(array, array->size + 1))
+            return NULL;
+
+    return bh_segarray_locate(array, array->size++, NULL);
+}
+
+void bh_segarray_pop_back(bh_segarray_t *array)
+{
+    if (array->size)
+        array->size--;
+}
+
+int bh_segarray_append(bh_segarray_t *array,
+                       const void *src,
+                       size_t count)
+{
+    size_t length;
+    char *to;
+
+    if (!count)
+        return 0;
+
+    if (array->size + count < array->size)
+        return -1;
+
+    /* Source can point into the array, elements are not moved by reserve */
+    if (array->size + count > array->capacity)
+        if (bh_segarray_reserve(array, array->size + count))
+            return -1;
+
+    /* Copy elements segment by segment */
+    while (count)
+    {
+        to = (char *)bh_segarray_locate(array, array->size, &length);
+        if (length > count)
+            length = count;
+
+        memcpy(to, src, length * array->element);
+        src = (const char *)src + length * array->element;
+        array->size += length;
+        count -= length;
+    }
+
+    return 0;
+}
+
+void *bh_segarray_at(bh_segarray_t *array,
+                     size_t index)
+{
+    if (index >= array->size)
+        return NULL;
+
+    return bh_segarray_locate(array, index, NULL);
+}
+
+void *bh_segarray_span(bh_segarray_t *array,
+                       size_t index,
+                       size_t *count)
+{
+    void *result;
+
+    if (index >= array->size)
+    {
+        *count = 0;
+        return NULL;
+    }
+
+    result = bh_segarray_locate(array, index, count);
+    if (*count > array->size - index)
+        *count = array->size - index;
+
+    return result;
+}
+
+int bh_columns_init(bh_columns_t *columns,
+                    const size_t *element,
+                    size_t count)
+{
+    return bh_columns_init_alloc(columns, element, count, NULL);
+}
+
+int bh_columns_init_alloc(bh_columns_t *columns,
+                          const size_t *element,
+                          size_t count,
+                          const bh_allocator_t *allocator)
+{
+    size_t i;
+
+    memset(columns, 0, sizeof(*columns));
+    columns->growth = BH_GROWTH_DEFAULT;
+    columns->allocator = (allocator) ? (allocator) : (bh_allocator_default());
+
+    if (!count || count > BH_COLUMNS_MAX)
+        return -1;
+
+    for (i = 0; i < count; i++)
+    {
+        if (!element[i])
+            return -1;
+        columns->element[i] = element[i];
+    }
+
+    columns->count = count;
+    return 0;
+}
+
+void bh_columns_destroy(bh_columns_t *columns)
+{
+    size_t i;
+
+    for (i = 0; i < columns->count; i++)
+        bh_free(columns->allocator, columns->data[i], columns->capacity * columns->element[i]);
+}
+
+void bh_columns_clear(bh_columns_t *columns)
+{
+    columns->size = 0;
+}
+
+int bh_columns_reserve(bh_columns_t *columns,
+                       size_t size)
+{
+    void *data[BH_COLUMNS_MAX];
+    size_t capacity, i;
+
+    /* Requested capacity should be in range [columns->size; max_capacity] */
+    capacity = size;
+    if (capacity < columns->size)
+        capacity = columns->size;
+
+    for (i = 0; i < columns->count; i++)
+        if (capacity > ((size_t)-1) / columns->element[i])
+            return -1;
+
+    /* Prevent same size reallocation */
+    if (capacity == columns->capacity)
+        return 0;
+
+    /* Allocate all columns first, so failure leaves container untouched */
+    for (i = 0; i < columns->count; i++)
+    {
+        data[i] = NULL;
+        if (!capacity)
+            continue;
+
+        data[i] = bh_alloc(columns->allocator, capacity * columns->element[i]);
+        if (!data[i])
+        {
+            while (i--)
+                bh_free(columns->allocator, data[i], capacity * columns->element[i]);
+            return -1;
+        }
+
+        if (columns->size)
+            memcpy(data[i], columns->data[i], columns->size * columns->element[i]);
+    }
+
+    for (i = 0; i < columns->count; i++)
+    {
+        bh_free(columns->allocator, columns->data[i], columns->capacity * columns->element[i]);
+        columns->data[i] = data[i];
+    }
+
+    columns->capacity = capacity;
+    return 0;
+}
+
+void bh_columns_set_growth(bh_columns_t *columns,
+                           size_t growth)
+{
+    columns->growth = growth;
+}
+
+int bh_columns_resize(bh_columns_t *columns,
+                      size_t size)
+{
+    if (size > columns->capacity)
+        if (bh_columns_reserve(columns, size))
+            return -1;
+
+    columns->size = size;
+    return 0;
+}
+
+int bh_columns_insert(bh_columns_t *columns,
+                      size_t index)
+{
+    return bh_columns_insert_n(columns, index, 1);
+}
+
+int bh_columns_insert_n(bh_columns_t *columns,
+                        size_t index,
+                        size_t count)
+{
+    size_t capacity, i;
+    char *from;
+
+    /* Check capacity, potential size overflow and reserve capacity */
+    if (columns->capacity < columns->size + count)
+    {
+        capacity = bh_grow(columns->capacity, columns->size + count, columns->growth);
+        if (columns->size + count < columns->size || bh_columns_reserve(columns, capacity))
+            return -1;
+    }
+
+    /* Index should be in valid range */
+    index = (index > columns->size) ? (columns->size) : (index);
+
+    /* Shift each column to the right */
+    if (index < columns->size && count)
+    {
+        for (i = 0; i < columns->count; i++)
+        {
+            from = (char *)columns->data[i] + index * columns->element[i];
+            memmove(from + count * columns->element[i], from,
+                    (columns->size - index) * columns->element[i]);
+        }
+    }
 
-    /* Update array fields and return iterator */
-    array->size--;
-    if (index >= array->size)
-        return NULL;
+    columns->size += count;
+    return 0;
+}
 
-    return iter;
+void bh_columns_remove(bh_columns_t *columns,
+                       size_t index)
+{
+    bh_columns_erase_range(columns, index, index + 1);
 }
 
-void *bh_array_next(bh_array_t *array,
-                    void *iter)
+void bh_columns_erase_range(bh_columns_t *columns,
+                            size_t first,
+                            size_t last)
 {
-    char *item = (char *)iter;
+    size_t i;
+    char *to;
 
-    /* Advance or set iterator */
-    if (item)
-        item += array->element;
-    else
-        item = array->data;
+    /* Range should be valid */
+    if (last > columns->size)
+        last = columns->size;
+    if (first >= last)
+        return;
 
-    /* Check iterator for validity */
-    if (item >= (char *)array->data + array->size * array->element)
-        return NULL;
+    /* Shift each column to the left */
+    if (last < columns->size)
+    {
+        for (i = 0; i < columns->count; i++)
+        {
+            to = (char *)columns->data[i] + first * columns->element[i];
+            memmove(to, to + (last - first) * columns->element[i],
+                    (columns->size - last) * columns->element[i]);
+        }
+    }
 
-    return item;
+    columns->size -= last - first;
 }
 
-void *bh_array_value(bh_array_t *array,
-                     void *iter)
+void *bh_columns_at(bh_columns_t *columns,
+                    size_t column,
+                    size_t index)
 {
-    (void)array;
-    return iter;
+    return (char *)columns->data[column] + index * columns->element[column];
 }
 
 void bh_map_init(bh_map_t *map,
@@ -166,12 +876,23 @@ void bh_map_init(bh_map_t *map,
                  size_t value,
                  bh_compare_cb_t compare,
                  bh_hash_cb_t hash)
+{
+    bh_map_init_alloc(map, key, value, compare, hash, NULL);
+}
+
+void bh_map_init_alloc(bh_map_t *map,
+                       size_t key,
+                       size_t value,
+                       bh_compare_cb_t compare,
+                       bh_hash_cb_t hash,
+                       const bh_allocator_t *allocator)
 {
     memset(map, 0, sizeof(*map));
     map->element.key = key;
     map->element.value = value;
     map->compare = compare;
     map->hash = hash;
+    map->allocator = (allocator) ? (allocator) : (bh_allocator_default());
 
     if (!map->element.key || !map->element.value)
         abort();
@@ -179,11 +900,14 @@ void bh_map_init(bh_map_t *map,
 
 void bh_map_destroy(bh_map_t *map)
 {
+    size_t capacity;
+
     if (map->capacity)
     {
-        free(map->data.key);
-        free(map->data.value);
-        free(map->data.psl);
+        capacity = map->capacity + 1;
+        bh_free(map->allocator, map->data.key, map->element.key * capacity);
+        bh_free(map->allocator, map->data.value, map->element.value * capacity);
+        bh_free(map->allocator, map->data.psl, sizeof(size_t) * capacity);
     }
 }
 
@@ -237,25 +961,22 @@ int bh_map_reserve(bh_map_t *map,
     if (capacity == map->capacity)
         return 0;
 
-    bh_map_init(&other, map->element.key, map->element.value, map->compare, map->hash);
+    bh_map_init_alloc(&other, map->element.key, map->element.value, map->compare, map->hash, map->allocator);
     if (capacity)
     {
         void *iter;
 
         /* Prepare new map */
-        other.data.key = malloc(other.element.key * (capacity + 1));
-        other.data.value = malloc(other.element.value * (capacity + 1));
-        other.data.psl = malloc(sizeof(size_t) * (capacity + 1));
+        other.data.key = bh_alloc(map->allocator, other.element.key * (capacity + 1));
+        other.data.value = bh_alloc(map->allocator, other.element.value * (capacity + 1));
+        other.data.psl = bh_alloc(map->allocator, sizeof(size_t) * (capacity + 1));
         other.capacity = capacity;
 
         if (!other.data.key || !other.data.value || !other.data.psl)
         {
-            if (other.data.key)
-                free(other.data.key);
-            if (other.data.value)
-                free(other.data.value);
-            if (other.data.psl)
-                free(other.data.psl);
+            bh_free(map->allocator, other.data.key, other.element.key * (capacity + 1));
+            bh_free(map->allocator, other.data.value, other.element.value * (capacity + 1));
+            bh_free(map->allocator, other.data.psl, sizeof(size_t) * (capacity + 1));
             return -1;
         }
 
@@ -283,8 +1004,9 @@ int bh_map_reserve(bh_map_t *map,
 void *bh_map_insert(bh_map_t *map,
                     void *key)
 {
-    size_t bucket, *item_psl, *bucket_psl;
+    size_t bucket, tmp, *item_psl, *bucket_psl;
     void *item_key, *item_value, *bucket_key, *bucket_value, *result;
+    bh_swap_cb_t swap_key, swap_value;
 
     /* Capcity should try to keep 87.5% load factor */
     if (map->size + 1 > map->capacity / 8 * 7)
@@ -301,6 +1023,10 @@ void *bh_map_insert(bh_map_t *map,
     *item_psl = 1;
     result = NULL;
 
+    /* Select swap functions for keys and values */
+    swap_key = bh_swap_func(map->element.key);
+    swap_value = bh_swap_func(map->element.value);
+
     /* Find empty bucket */
     while (map->data.psl[bucket])
     {
@@ -311,9 +1037,11 @@ void *bh_map_insert(bh_map_t *map,
             bucket_key = (char *)map->data.key + bucket * map->element.key;
             bucket_value = (char *)map->data.value + bucket * map->element.value;
 
-            bh_swap(bucket_psl, item_psl, sizeof(size_t));
-            bh_swap(bucket_key, item_key, map->element.key);
-            bh_swap(bucket_value, item_value, map->element.key);
+            tmp = *bucket_psl;
+            *bucket_psl = *item_psl;
+            *item_psl = tmp;
+            swap_key(bucket_key, item_key, map->element.key);
+            swap_value(bucket_value, item_value, map->element.value);
 
             /* If this is first swap - store current bucket address */
             if (!result)
@@ -466,15 +1194,23 @@ void *bh_map_value(bh_map_t *map,
 
 void bh_queue_init(bh_queue_t *queue,
                    size_t element)
+{
+    bh_queue_init_alloc(queue, element, NULL);
+}
+
+void bh_queue_init_alloc(bh_queue_t *queue,
+                         size_t element,
+                         const bh_allocator_t *allocator)
 {
     memset(queue, 0, sizeof(*queue));
     queue->element = element;
+    queue->growth = BH_GROWTH_DEFAULT;
+    queue->allocator = (allocator) ? (allocator) : (bh_allocator_default());
 }
 
 void bh_queue_destroy(bh_queue_t *queue)
 {
-    if (queue->data)
-        free(queue->data);
+    bh_free(queue->allocator, queue->data, queue->capacity * queue->element);
 }
 
 size_t bh_queue_size(bh_queue_t *queue)
@@ -494,6 +1230,30 @@ void bh_queue_clear(bh_queue_t *queue)
     queue->head = 0;
 }
 
+static void bh_queue_unwrap(bh_queue_t *queue,
+                            char *data,
+                            size_t capacity)
+{
+    size_t head_size, extra;
+
+    head_size = queue->capacity - queue->head;
+    extra = capacity - queue->capacity;
+
+    /* Move the smaller part: [0, tail) after old end or [head, end) to the new end */
+    if (queue->tail <= extra && queue->tail < head_size)
+    {
+        memcpy(data + queue->capacity * queue->element, data, queue->tail * queue->element);
+        queue->tail = (queue->capacity + queue->tail) % capacity;
+    }
+    else
+    {
+        memmove(data + (capacity - head_size) * queue->element,
+                data + queue->head * queue->element,
+                head_size * queue->element);
+        queue->head = capacity - head_size;
+    }
+}
+
 int bh_queue_reserve(bh_queue_t *queue,
                      size_t size)
 {
@@ -515,13 +1275,31 @@ int bh_queue_reserve(bh_queue_t *queue,
     if (capacity == queue->capacity)
         return 0;
 
-    /* Allocate and copy data */
+    /* Growing queue - reallocate data and move wrapped part */
+    if (capacity > queue->capacity)
+    {
+        data = bh_realloc(queue->allocator, queue->data,
+                          queue->element * queue->capacity, queue->element * capacity);
+        if (!data)
+            return -1;
+
+        if (queue->head > queue->tail)
+            bh_queue_unwrap(queue, data, capacity);
+        else if (queue->head == queue->tail)
+            queue->head = queue->tail = 0;
+
+        queue->data = data;
+        queue->capacity = capacity;
+        return 0;
+    }
+
+    /* Shrinking queue - allocate and copy data */
     data = NULL;
     head = 0;
     tail = 0;
     if (capacity)
     {
-        data = malloc(queue->element * capacity);
+        data = bh_alloc(queue->allocator, queue->element * capacity);
         if (!data)
             return -1;
 
@@ -559,8 +1337,7 @@ int bh_queue_reserve(bh_queue_t *queue,
     }
 
     /* Update array fields*/
-    if (queue->data)
-        free(queue->data);
+    bh_free(queue->allocator, queue->data, queue->element * queue->capacity);
     queue->head = head;
     queue->tail = tail;
     queue->data = data;
@@ -569,6 +1346,12 @@ int bh_queue_reserve(bh_queue_t *queue,
     return 0;
 }
 
+void bh_queue_set_growth(bh_queue_t *queue,
+                         size_t growth)
+{
+    queue->growth = growth;
+}
+
 void *bh_queue_push_front(bh_queue_t *queue)
 {
     size_t size;
@@ -580,8 +1363,8 @@ void *bh_queue_push_front(bh_queue_t *queue)
         size_t capacity;
 
         /* Check potential size overflow and reserve capacity */
-        capacity = (queue->capacity) ? (queue->capacity * 2) : (16);
-        if (capacity < queue->capacity || bh_queue_reserve(queue, capacity))
+        capacity = bh_grow(queue->capacity, size + 2, queue->growth);
+        if (size + 2 < size || bh_queue_reserve(queue, capacity))
             return NULL;
     }
 
@@ -602,8 +1385,8 @@ void *bh_queue_push_back(bh_queue_t *queue)
         size_t capacity;
 
         /* Check potential size overflow and reserve capacity */
-        capacity = (queue->capacity) ? (queue->capacity * 2) : (16);
-        if (capacity < queue->capacity || bh_queue_reserve(queue, capacity))
+        capacity = bh_grow(queue->capacity, size + 2, queue->growth);
+        if (size + 2 < size || bh_queue_reserve(queue, capacity))
             return NULL;
     }
 
@@ -685,4 +1468,405 @@ void *bh_queue_value(bh_queue_t *queue,
 {
     (void)queue;
     return iter;
-}
\ No newline at end of file
+}
+
+void bh_topk_init(bh_topk_t *topk,
+                  size_t element,
+                  size_t count,
+                  bh_compare_cb_t compare)
+{
+    bh_topk_init_alloc(topk, element, count, compare, NULL);
+}
+
+void bh_topk_init_alloc(bh_topk_t *topk,
+                        size_t element,
+                        size_t count,
+                        bh_compare_cb_t compare,
+                        const bh_allocator_t *allocator)
+{
+    memset(topk, 0, sizeof(*topk));
+    topk->element = element;
+    topk->capacity = count;
+    topk->compare = compare;
+    topk->allocator = (allocator) ? (allocator) : (bh_allocator_default());
+}
+
+void bh_topk_destroy(bh_topk_t *topk)
+{
+    bh_free(topk->allocator, topk->data, topk->capacity * topk->element);
+}
+
+void bh_topk_clear(bh_topk_t *topk)
+{
+    topk->size = 0;
+    topk->sorted = 0;
+}
+
+static int bh_topk_prepare(bh_topk_t *topk)
+{
+    /* Allocate storage on first use */
+    if (!topk->data && topk->capacity)
+    {
+        if (topk->capacity > ((size_t)-1) / topk->element)
+            return -1;
+
+        topk->data = bh_alloc(topk->allocator, topk->capacity * topk->element);
+        if (!topk->data)
+            return -1;
+    }
+
+    /* Restore heap after sorting */
+    if (topk->sorted)
+    {
+        bh_heap_make(topk->data, topk->element, topk->size, topk->compare);
+        topk->sorted = 0;
+    }
+
+    return 0;
+}
+
+int bh_topk_push(bh_topk_t *topk,
+                 const void *item)
+{
+    if (bh_topk_prepare(topk))
+        return -1;
+
+    /* Heap is not full - simply insert element */
+    if (topk->size < topk->capacity)
+    {
+        bh_heap_push(item, topk->data, topk->element, topk->size, topk->compare);
+        topk->size++;
+    }
+    else if (topk->size && topk->compare(item, topk->data) < 0)
+        bh_heap_replace(item, topk->data, topk->element, topk->size, topk->compare);
+
+    return 0;
+}
+
+int bh_topk_push_n(bh_topk_t *topk,
+                   const void *items,
+                   size_t count)
+{
+    const char *item;
+    size_t fill;
+
+    if (bh_topk_prepare(topk))
+        return -1;
+
+    item = (const char *)items;
+
+    /* Fill the heap in one go and heapify it */
+    fill = topk->capacity - topk->size;
+    if (fill > count)
+        fill = count;
+
+    if (fill)
+    {
+        memmove((char *)topk->data + topk->size * topk->element, item, fill * topk->element);
+        topk->size += fill;
+        bh_heap_make(topk->data, topk->element, topk->size, topk->compare);
+        item += fill * topk->element;
+        count -= fill;
+    }
+
+    /* Replace top element with better elements */
+    for (; count && topk->size; count--, item += topk->element)
+    {
+        if (topk->compare(item, topk->data) < 0)
+            bh_heap_replace(item, topk->data, topk->element, topk->size, topk->compare);
+    }
+
+    return 0;
+}
+
+void *bh_topk_top(bh_topk_t *topk)
+{
+    if (!topk->size)
+        return NULL;
+
+    /* Worst element is at the top of the heap or at the end if sorted */
+    if (topk->sorted)
+        return (char *)topk->data + (topk->size - 1) * topk->element;
+
+    return topk->data;
+}
+
+void bh_topk_sort(bh_topk_t *topk)
+{
+    size_t size;
+
+    if (topk->sorted)
+        return;
+
+    /* Heap sort kept elements */
+    for (size = topk->size; size; size--)
+        bh_heap_pop(topk->data, topk->element, size, topk->compare);
+    topk->sorted = 1;
+}
+
+void bh_pqueue_init(bh_pqueue_t *queue,
+                    size_t element,
+                    size_t arity,
+                    bh_compare_cb_t compare)
+{
+    bh_pqueue_init_alloc(queue, element, arity, compare, NULL);
+}
+
+void bh_pqueue_init_alloc(bh_pqueue_t *queue,
+                          size_t element,
+                          size_t arity,
+                          bh_compare_cb_t compare,
+                          const bh_allocator_t *allocator)
+{
+    memset(queue, 0, sizeof(*queue));
+    queue->element = element;
+    queue->arity = (arity >= 2) ? (arity) : (BH_PQUEUE_ARITY);
+    queue->growth = BH_GROWTH_DEFAULT;
+    queue->compare = compare;
+    queue->allocator = (allocator) ? (allocator) : (bh_allocator_default());
+}
+
+void bh_pqueue_destroy(bh_pqueue_t *queue)
+{
+    if (queue->data)
+        bh_free(queue->allocator, queue->data, queue->element * (queue->capacity + 1));
+}
+
+void bh_pqueue_clear(bh_pqueue_t *queue)
+{
+    queue->size = 0;
+}
+
+int bh_pqueue_reserve(bh_pqueue_t *queue,
+                      size_t size)
+{
+    void *data;
+    size_t capacity;
+
+    /* Requested capacity should be in range [queue->size; max_capacity] */
+    capacity = size;
+    if (capacity < queue->size)
+        capacity = queue->size;
+
+    /* One additional element is used as a temporary for sifting */
+    if (capacity >= ((size_t)-1) / queue->element)
+        return -1;
+
+    /* Prevent same size reallocation */
+    if (capacity == queue->capacity)
+        return 0;
+
+    /* Reallocate data (large blocks can be remapped without copying) */
+    if (capacity)
+    {
+        data = bh_realloc(queue->allocator, queue->data,
+                          (queue->data) ? (queue->element * (queue->capacity + 1)) : (0),
+                          queue->element * (capacity + 1));
+        if (!data)
+            return -1;
+    }
+    else
+    {
+        if (queue->data)
+            bh_free(queue->allocator, queue->data, queue->element * (queue->capacity + 1));
+        data = NULL;
+    }
+
+    /* Update queue fields */
+    queue->data = data;
+    queue->capacity = capacity;
+    return 0;
+}
+
+void bh_pqueue_set_growth(bh_pqueue_t *queue,
+                          size_t growth)
+{
+    queue->growth = growth;
+}
+
+static int bh_pqueue_grow(bh_pqueue_t *queue,
+                          size_t count)
+{
+    size_t capacity;
+
+    if (queue->capacity >= queue->size + count && queue->size + count >= queue->size)
+        return 0;
+
+    /* Check potential size overflow and reserve capacity */
+    capacity = bh_grow(queue->capacity, queue->size + count, queue->growth);
+    if (queue->size + count < queue->size || bh_pqueue_reserve(queue, capacity))
+        return -1;
+
+    return 0;
+}
+
+static void bh_pqueue_sift_up(bh_pqueue_t *queue,
+                              size_t index,
+                              const void *item)
+{
+    char *data;
+    size_t parent, element;
+
+    data = (char *)queue->data;
+    element = queue->element;
+
+    /* Move hole up until item can be placed */
+    while (index)
+    {
+        parent = (index - 1) / queue->arity;
+        if (!(queue->compare(data + parent * element, item) < 0))
+            break;
+
+        memcpy(data + index * element, data + parent * element, element);
+        index = parent;
+    }
+
+    memcpy(data + index * element, item, element);
+}
+
+static void bh_pqueue_sift_down(bh_pqueue_t *queue,
+                                size_t index,
+                                const void *item)
+{
+    char *data, *child, *last, *biggest;
+    size_t first, count, element;
+
+    data = (char *)queue->data;
+    element = queue->element;
+
+    /* Move hole down until item can be placed */
+    while ((first = index * queue->arity + 1) < queue->size)
+    {
+        /* Find biggest child */
+        count = queue->size - first;
+        if (count > queue->arity)
+            count = queue->arity;
+
+        biggest = data + first * element;
+        last = biggest + count * element;
+        for (child = biggest + element; child < last; child += element)
+        {
+            if (queue->compare(biggest, child) < 0)
+                biggest = child;
+        }
+
+        if (!(queue->compare(item, biggest) < 0))
+            break;
+
+        memcpy(data + index * element, biggest, element);
+        index = (biggest - data) / element;
+    }
+
+    memcpy(data + index * element, item, element);
+}
+
+int bh_pqueue_push(bh_pqueue_t *queue,
+                   const void *item)
+{
+    size_t offset;
+    char *data, *tmp;
+
+    /* Item can point into the queue, which can be reallocated */
+    data = (char *)queue->data;
+    offset = (size_t)-1;
+    if (data && (const char *)item >= data && (const char *)item < data + (queue->capacity + 1) * queue->element)
+        offset = (const char *)item - data;
+
+    if (bh_pqueue_grow(queue, 1))
+        return -1;
+
+    if (offset != (size_t)-1)
+        item = (char *)queue->data + offset;
+
+    /* Copy item into temporary, since it can point into the queue */
+    tmp = (char *)queue->data + queue->capacity * queue->element;
+    memmove(tmp, item, queue->element);
+    bh_pqueue_sift_up(queue, queue->size++, tmp);
+    return 0;
+}
+
+int bh_pqueue_push_n(bh_pqueue_t *queue,
+                     const void *items,
+                     size_t count)
+{
+    char *data, *tmp;
+    const char *item;
+    size_t i, offset;
+
+    if (!count)
+        return 0;
+
+    /* Items can point into the queue, which can be reallocated */
+    data = (char *)queue->data;
+    offset = (size_t)-1;
+    if (data && (const char *)items >= data && (const char *)items < data + (queue->capacity + 1) * queue->element)
+        offset = (const char *)items - data;
+
+    if (bh_pqueue_grow(queue, count))
+        return -1;
+
+    data = (char *)queue->data;
+    item = (const char *)items;
+    if (offset != (size_t)-1)
+        item = data + offset;
+
+    /* Few elements - insert them one by one */
+    if (count < queue->size)
+    {
+        for (i = 0; i < count; i++, item += queue->element)
+            bh_pqueue_push(queue, item);
+        return 0;
+    }
+
+    /* Append elements and rebuild the heap bottom up */
+    memmove(data + queue->size * queue->element, item, count * queue->element);
+    queue->size += count;
+
+    tmp = data + queue->capacity * queue->element;
+    for (i = (queue->size - 1) / queue->arity + 1; i--;)
+    {
+        memcpy(tmp, data + i * queue->element, queue->element);
+        bh_pqueue_sift_down(queue, i, tmp);
+    }
+
+    return 0;
+}
+
+void *bh_pqueue_top(bh_pqueue_t *queue)
+{
+    if (!queue->size)
+        return NULL;
+
+    return queue->data;
+}
+
+void bh_pqueue_pop(bh_pqueue_t *queue)
+{
+    char *last;
+
+    if (!queue->size)
+        return;
+
+    /* Sift last element down from the top */
+    queue->size--;
+    if (queue->size)
+    {
+        last = (char *)queue->data + queue->size * queue->element;
+        bh_pqueue_sift_down(queue, 0, last);
+    }
+}
+
+int bh_pqueue_replace_top(bh_pqueue_t *queue,
+                          const void *item)
+{
+    char *tmp;
+
+    if (!queue->size)
+        return bh_pqueue_push(queue, item);
+
+    /* Copy item into temporary, since it can point into the queue */
+    tmp = (char *)queue->data + queue->capacity * queue->element;
+    memmove(tmp, item, queue->element);
+    bh_pqueue_sift_down(queue, 0, tmp);
+    return 0;
+}
@@ -0,0 +1,335 @@
+/*
+ * BHLib
+ *
+ * Copyright (c) 2024 Mikhail Romanko
+ */
+#if !defined(_WIN32)
+#if !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200112L
+#endif
+#if !defined(_FILE_OFFSET_BITS)
+#define _FILE_OFFSET_BITS 64
+#endif
+#endif
+
+#include <bh/algo.h>
+#include <bh/ds.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BH_EXTSORT_BLOCK        65536
+#define BH_EXTSORT_MAX_RUNS     256
+
+/* Temporary files can exceed 2 GiB, while long is 32-bit on Win32 */
+#if defined(_WIN32)
+typedef __int64 bh_extsort_offset_t;
+#define bh_extsort_seek(file, offset) _fseeki64((file), (offset), SEEK_SET)
+#else
+typedef off_t bh_extsort_offset_t;
+#define bh_extsort_seek(file, offset) fseeko((file), (offset), SEEK_SET)
+#endif
+
+typedef struct
+{
+    bh_extsort_offset_t offset;
+    size_t size;
+} bh_extsort_run_t;
+
+typedef struct
+{
+    FILE *file;
+    bh_extsort_offset_t offset;
+    size_t left;
+    char *buffer;
+    size_t capacity;
+    size_t element;
+} bh_extsort_reader_t;
+
+typedef struct
+{
+    FILE *file;
+    char *buffer;
+    size_t size;
+    size_t capacity;
+    size_t element;
+} bh_extsort_writer_t;
+
+static int bh_extsort_refill(bh_merge_run_t *run)
+{
+    bh_extsort_reader_t *reader;
+    size_t count;
+
+    reader = (bh_extsort_reader_t *)run->context;
+    if (!reader->left)
+        return -1;
+
+    /* Read next block of the run (runs share the same file) */
+    count = (reader->left < reader->capacity) ? (reader->left) : (reader->capacity);
+    if (bh_extsort_seek(reader->file, reader->offset))
+        return -1;
+
+    count = fread(reader->buffer, reader->element, count, reader->file);
+    if (!count)
+        return -1;
+
+    reader->offset += (bh_extsort_offset_t)count * reader->element;
+    reader->left -= count;
+    run->data = reader->buffer;
+    run->size = count;
+    return 0;
+}
+
+static int bh_extsort_flush(bh_extsort_writer_t *writer)
+{
+    size_t count;
+
+    /* Write buffered elements in one block */
+    count = fwrite(writer->buffer, writer->element, writer->size, writer->file);
+    if (count != writer->size)
+        return -1;
+
+    writer->size = 0;
+    return 0;
+}
+
+static int bh_extsort_write(const void *item,
+                            void *data)
+{
+    bh_extsort_writer_t *writer;
+
+    writer = (bh_extsort_writer_t *)data;
+    memcpy(writer->buffer + writer->size * writer->element, item, writer->element);
+
+    if (++writer->size == writer->capacity)
+        return bh_extsort_flush(writer);
+
+    return 0;
+}
+
+static int bh_extsort_split(FILE *in,
+                            FILE *out,
+                            FILE **file,
+                            bh_array_t *runs,
+                            size_t element,
+                            size_t memory,
+                            bh_compare_cb_t compare)
+{
+    bh_extsort_run_t *run;
+    char *buffer;
+    size_t capacity, size;
+    bh_extsort_offset_t offset;
+    int result;
+
+    /* Load as many elements as memory limit allows */
+    capacity = memory / element;
+    if (capacity < 2)
+        capacity = 2;
+
+    buffer = malloc(capacity * element);
+    if (!buffer)
+        return -1;
+
+    result = 0;
+    offset = 0;
+    while (!result)
+    {
+        /* Input should contain only whole elements */
+        size = fread(buffer, 1, capacity * element, in);
+        if (ferror(in) || size % element)
+        {
+            result = -1;
+            break;
+        }
+
+        size /= element;
+        if (!size)
+            break;
+
+        bh_sort(buffer, element, size, compare);
+
+        /* Whole input fits into memory - write it directly */
+        if (size < capacity && !bh_array_size(runs))
+        {
+            if (fwrite(buffer, element, size, out) != size)
+                result = -1;
+            break;
+        }
+
+        /* Spill sorted run into temporary file */
+        if (!*file && (*file = tmpfile()) == NULL)
+        {
+            result = -1;
+            break;
+        }
+
+        run = bh_array_insert(runs, bh_array_size(runs));
+        if (!run || fwrite(buffer, element, size, *file) != size)
+        {
+            result = -1;
+            break;
+        }
+
+        run->offset = offset;
+        run->size = size;
+        offset += (bh_extsort_offset_t)size * element;
+    }
+
+    free(buffer);
+    return result;
+}
+
+static int bh_extsort_merge(FILE *from,
+                            bh_extsort_run_t *runs,
+                            size_t count,
+                            FILE *to,
+                            size_t element,
+                            size_t memory,
+                            bh_compare_cb_t compare)
+{
+    bh_extsort_reader_t readers[BH_EXTSORT_MAX_RUNS];
+    bh_merge_run_t merge[BH_EXTSORT_MAX_RUNS];
+    bh_extsort_writer_t writer;
+    size_t block, i;
+    char *buffer;
+    int result;
+
+    /* Split memory between run buffers and output buffer */
+    block = memory / (count + 1) / element;
+    if (!block)
+        block = 1;
+
+    buffer = malloc(block * element * (count + 1));
+    if (!buffer)
+        return -1;
+
+    for (i = 0; i < count; i++)
+    {
+        readers[i].file = from;
+        readers[i].offset = runs[i].offset;
+        readers[i].left = runs[i].size;
+        readers[i].buffer = buffer + i * block * element;
+        readers[i].capacity = block;
+        readers[i].element = element;
+
+        merge[i].data = NULL;
+        merge[i].size = 0;
+        merge[i].refill = bh_extsort_refill;
+        merge[i].context = readers + i;
+    }
+
+    writer.file = to;
+    writer.buffer = buffer + count * block * element;
+    writer.size = 0;
+    writer.capacity = block;
+    writer.element = element;
+
+    /* Merge runs and flush the rest of the output */
+    result = bh_merge_k(merge, count, element, compare, bh_extsort_write, &writer);
+    if (!result)
+        result = bh_extsort_flush(&writer);
+
+    /* Check that runs were read completely */
+    for (i = 0; i < count; i++)
+    {
+        if (readers[i].left)
+            result = -1;
+    }
+
+    free(buffer);
+    return result;
+}
+
+static int bh_extsort_pass(FILE *from,
+                           bh_array_t *runs,
+                           FILE *to,
+                           size_t fanin,
+                           size_t element,
+                           size_t memory,
+                           bh_compare_cb_t compare)
+{
+    bh_extsort_run_t *run, *merged;
+    size_t i, j, k, count, size;
+    bh_extsort_offset_t offset;
+
+    /* Merge groups of runs, merged runs replace them in the array */
+    offset = 0;
+    for (i = 0, j = 0; i < bh_array_size(runs); i += count, j++)
+    {
+        run = (bh_extsort_run_t *)bh_array_at(runs, i);
+        count = bh_array_size(runs) - i;
+        if (count > fanin)
+            count = fanin;
+
+        if (bh_extsort_merge(from, run, count, to, element, memory, compare))
+            return -1;
+
+        for (k = 0, size = 0; k < count; k++)
+            size += run[k].size;
+
+        merged = (bh_extsort_run_t *)bh_array_at(runs, j);
+        merged->offset = offset;
+        merged->size = size;
+        offset += (bh_extsort_offset_t)size * element;
+    }
+
+    return bh_array_resize(runs, j);
+}
+
+int bh_sort_external(FILE *in,
+                     FILE *out,
+                     size_t element,
+                     size_t memory,
+                     bh_compare_cb_t compare)
+{
+    bh_array_t runs;
+    size_t fanin;
+    FILE *from, *to, *tmp;
+    int result;
+
+    if (!element)
+        return -1;
+
+    /* Sort input by chunks and spill them into temporary file */
+    bh_array_init(&runs, sizeof(bh_extsort_run_t));
+    from = NULL;
+    to = NULL;
+    result = bh_extsort_split(in, out, &from, &runs, element, memory, compare);
+
+    /* Calculate how many runs can be merged at once */
+    fanin = memory / BH_EXTSORT_BLOCK;
+    if (fanin > BH_EXTSORT_MAX_RUNS)
+        fanin = BH_EXTSORT_MAX_RUNS;
+    if (fanin < 2)
+        fanin = 2;
+
+    /* Merge runs into bigger runs until they can be merged in one pass */
+    while (!result && bh_array_size(&runs) > fanin)
+    {
+        if (!to && (to = tmpfile()) == NULL)
+        {
+            result = -1;
+            break;
+        }
+
+        rewind(to);
+        result = bh_extsort_pass(from, &runs, to, fanin, element, memory, compare);
+
+        /* Merged runs become the source for the next pass */
+        tmp = from;
+        from = to;
+        to = tmp;
+    }
+
+    /* Final merge into the output */
+    if (!result && bh_array_size(&runs))
+        result = bh_extsort_merge(from, bh_array_data(&runs), bh_array_size(&runs),
+                                  out, element, memory, compare);
+
+    if (from)
+        fclose(from);
+    if (to)
+        fclose(to);
+    bh_array_destroy(&runs);
+    return result;
+}
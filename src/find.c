@@ -0,0 +1,306 @@
+/*
+ * BHLib
+ *
+ * Copyright (c) 2024 Mikhail Romanko
+ */
+#include <bh/algo.h>
+#include <string.h>
+#include <stdint.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BH_FIND_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(BH_FIND_SSE2) && defined(__AVX2__)
+#define BH_FIND_AVX2
+#define BH_FIND_AVX2_TARGET
+#include <immintrin.h>
+#elif defined(BH_FIND_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BH_FIND_AVX2
+#define BH_FIND_AVX2_DISPATCH
+#define BH_FIND_AVX2_TARGET __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+
+typedef const char *(*bh_find_cb_t)(const char *, const char *, const void *);
+typedef size_t (*bh_count_cb_t)(const char **, const char *, const void *);
+
+typedef struct
+{
+    bh_find_cb_t find;
+    bh_count_cb_t count;
+} bh_find_kernel_t;
+
+static BH_INLINE unsigned int bh_find_ctz(unsigned int mask)
+{
+#if defined(__GNUC__)
+    return __builtin_ctz(mask);
+#else
+    unsigned int result;
+
+    for (result = 0; !(mask & 1); mask >>= 1)
+        result++;
+    return result;
+#endif
+}
+
+static BH_INLINE unsigned int bh_find_popcount(unsigned int mask)
+{
+#if defined(__GNUC__)
+    return __builtin_popcount(mask);
+#else
+    mask = mask - ((mask >> 1) & 0x55555555u);
+    mask = (mask & 0x33333333u) + ((mask >> 2) & 0x33333333u);
+    mask = (mask + (mask >> 4)) & 0x0f0f0f0fu;
+    return (mask * 0x01010101u) >> 24;
+#endif
+}
+
+/*
+ * Kernels compare whole vectors with the broadcasted item and return pointer
+ * to the first unprocessed element. Remaining tail is processed by the
+ * scalar loop.
+ */
+#define BH_FIND_KERNEL_DEFINE(name, attr, vec, bytes, type, load, set1, cmpeq, movemask) \
+static attr const char *name##_find(const char *p,                              \
+                                    const char *end,                            \
+                                    const void *item)                           \
+{                                                                               \
+    unsigned int mask;                                                          \
+    type value;                                                                 \
+    vec key;                                                                    \
+                                                                                \
+    memcpy(&value, item, sizeof(value));                                        \
+    key = set1(value);                                                          \
+    for (; end - p >= bytes; p += bytes)                                        \
+    {                                                                           \
+        mask = (unsigned int)movemask(cmpeq(load((const vec *)p), key));        \
+        if (mask)                                                               \
+            return p + bh_find_ctz(mask);                                       \
+    }                                                                           \
+    return p;                                                                   \
+}                                                                               \
+                                                                                \
+static attr size_t name##_count(const char **p,                                 \
+                                const char *end,                                \
+                                const void *item)                               \
+{                                                                               \
+    const char *current;                                                        \
+    size_t bits;                                                                \
+    type value;                                                                 \
+    vec key;                                                                    \
+                                                                                \
+    memcpy(&value, item, sizeof(value));                                        \
+    key = set1(value);                                                          \
+    for (current = *p, bits = 0; end - current >= bytes; current += bytes)      \
+        bits += bh_find_popcount((unsigned int)movemask(cmpeq(load((const vec *)current), key))); \
+    *p = current;                                                               \
+    return bits / sizeof(value);                                                \
+}
+
+#if defined(BH_FIND_SSE2)
+static BH_INLINE __m128i bh_find_cmpeq64_sse2(__m128i a,
+                                              __m128i b)
+{
+    __m128i mask;
+
+    /* Both 32-bit halves should be equal */
+    mask = _mm_cmpeq_epi32(a, b);
+    return _mm_and_si128(mask, _mm_shuffle_epi32(mask, _MM_SHUFFLE(2, 3, 0, 1)));
+}
+
+BH_FIND_KERNEL_DEFINE(bh_find1_sse2, , __m128i, 16, char, _mm_loadu_si128, _mm_set1_epi8, _mm_cmpeq_epi8, _mm_movemask_epi8)
+BH_FIND_KERNEL_DEFINE(bh_find2_sse2, , __m128i, 16, short, _mm_loadu_si128, _mm_set1_epi16, _mm_cmpeq_epi16, _mm_movemask_epi8)
+BH_FIND_KERNEL_DEFINE(bh_find4_sse2, , __m128i, 16, int, _mm_loadu_si128, _mm_set1_epi32, _mm_cmpeq_epi32, _mm_movemask_epi8)
+BH_FIND_KERNEL_DEFINE(bh_find8_sse2, , __m128i, 16, long long, _mm_loadu_si128, _mm_set1_epi64x, bh_find_cmpeq64_sse2, _mm_movemask_epi8)
+
+static const bh_find_kernel_t bh_find_sse2[4] =
+{
+    {bh_find1_sse2_find, bh_find1_sse2_count},
+    {bh_find2_sse2_find, bh_find2_sse2_count},
+    {bh_find4_sse2_find, bh_find4_sse2_count},
+    {bh_find8_sse2_find, bh_find8_sse2_count},
+};
+#endif
+
+#if defined(BH_FIND_AVX2)
+BH_FIND_KERNEL_DEFINE(bh_find1_avx2, BH_FIND_AVX2_TARGET, __m256i, 32, char, _mm256_loadu_si256, _mm256_set1_epi8, _mm256_cmpeq_epi8, _mm256_movemask_epi8)
+BH_FIND_KERNEL_DEFINE(bh_find2_avx2, BH_FIND_AVX2_TARGET, __m256i, 32, short, _mm256_loadu_si256, _mm256_set1_epi16, _mm256_cmpeq_epi16, _mm256_movemask_epi8)
+BH_FIND_KERNEL_DEFINE(bh_find4_avx2, BH_FIND_AVX2_TARGET, __m256i, 32, int, _mm256_loadu_si256, _mm256_set1_epi32, _mm256_cmpeq_epi32, _mm256_movemask_epi8)
+BH_FIND_KERNEL_DEFINE(bh_find8_avx2, BH_FIND_AVX2_TARGET, __m256i, 32, long long, _mm256_loadu_si256, _mm256_set1_epi64x, _mm256_cmpeq_epi64, _mm256_movemask_epi8)
+
+static const bh_find_kernel_t bh_find_avx2[4] =
+{
+    {bh_find1_avx2_find, bh_find1_avx2_count},
+    {bh_find2_avx2_find, bh_find2_avx2_count},
+    {bh_find4_avx2_find, bh_find4_avx2_count},
+    {bh_find8_avx2_find, bh_find8_avx2_count},
+};
+#endif
+
+static const bh_find_kernel_t *bh_find_kernel(size_t element)
+{
+#if defined(BH_FIND_AVX2_DISPATCH)
+    static int avx2 = -1;
+#endif
+    const bh_find_kernel_t *table;
+    int index;
+
+    switch (element)
+    {
+    case 1: index = 0; break;
+    case 2: index = 1; break;
+    case 4: index = 2; break;
+    case 8: index = 3; break;
+    default: return NULL;
+    }
+
+#if defined(BH_FIND_AVX2_DISPATCH)
+    /* Check CPU features once, races are harmless (same value is stored) */
+    if (avx2 < 0)
+    {
+        __builtin_cpu_init();
+        avx2 = __builtin_cpu_supports("avx2") != 0;
+    }
+    table = (avx2) ? (bh_find_avx2) : (bh_find_sse2);
+#elif defined(BH_FIND_AVX2)
+    table = bh_find_avx2;
+#elif defined(BH_FIND_SSE2)
+    table = bh_find_sse2;
+#else
+    table = NULL;
+#endif
+
+    return (table) ? (table + index) : (NULL);
+}
+
+/* Scalar loops for the tail and platforms without SIMD kernels */
+#define BH_FIND_SCALAR_DEFINE(name, type)                                       \
+static const char *name##_find(const char *p,                                   \
+                               const char *end,                                 \
+                               const void *item)                                \
+{                                                                               \
+    type key, value;                                                            \
+                                                                                \
+    memcpy(&key, item, sizeof(key));                                            \
+    for (; p < end; p += sizeof(type))                                          \
+    {                                                                           \
+        memcpy(&value, p, sizeof(value));                                       \
+        if (value == key)                                                       \
+            break;                                                              \
+    }                                                                           \
+    return p;                                                                   \
+}                                                                               \
+                                                                                \
+static size_t name##_count(const char *p,                                       \
+                           const char *end,                                     \
+                           const void *item)                                    \
+{                                                                               \
+    size_t result;                                                              \
+    type key, value;                                                            \
+                                                                                \
+    memcpy(&key, item, sizeof(key));                                            \
+    for (result = 0; p < end; p += sizeof(type))                                \
+    {                                                                           \
+        memcpy(&value, p, sizeof(value));                                       \
+        result += (value == key);                                               \
+    }                                                                           \
+    return result;                                                              \
+}
+
+BH_FIND_SCALAR_DEFINE(bh_find2, uint16_t)
+BH_FIND_SCALAR_DEFINE(bh_find4, uint32_t)
+BH_FIND_SCALAR_DEFINE(bh_find8, uint64_t)
+
+void *bh_find(const void *item,
+              void *array,
+              size_t element,
+              size_t size)
+{
+    const bh_find_kernel_t *kernel;
+    const char *start, *end, *result;
+
+    start = (const char *)array;
+    end = start + element * size;
+
+    /* Single bytes are handled by the C library */
+    if (element == 1)
+        return memchr(array, *(const unsigned char *)item, size);
+
+    kernel = bh_find_kernel(element);
+    if (kernel)
+    {
+        start = kernel->find(start, end, item);
+        if (start < end && !memcmp(start, item, element))
+            return (void *)start;
+    }
+
+    switch (element)
+    {
+    case 2: result = bh_find2_find(start, end, item); break;
+    case 4: result = bh_find4_find(start, end, item); break;
+    case 8: result = bh_find8_find(start, end, item); break;
+    default:
+        for (result = start; result < end; result += element)
+        {
+            if (!memcmp(result, item, element))
+                break;
+        }
+    }
+
+    return (result < end) ? ((void *)result) : (NULL);
+}
+
+void *bh_find_if(const void *item,
+                 void *array,
+                 size_t element,
+                 size_t size,
+                 bh_compare_cb_t compare)
+{
+    char *current, *end;
+
+    current = (char *)array;
+    end = current + element * size;
+    for (; current < end; current += element)
+    {
+        if (!compare(current, item))
+            return current;
+    }
+
+    return NULL;
+}
+
+size_t bh_count(const void *item,
+                const void *array,
+                size_t element,
+                size_t size)
+{
+    const bh_find_kernel_t *kernel;
+    const char *start, *end;
+    size_t result;
+
+    start = (const char *)array;
+    end = start + element * size;
+    result = 0;
+
+    kernel = bh_find_kernel(element);
+    if (kernel)
+        result = kernel->count(&start, end, item);
+
+    switch (element)
+    {
+    case 1:
+        for (; start < end; start++)
+            result += (*start == *(const char *)item);
+        break;
+    case 2: result += bh_find2_count(start, end, item); break;
+    case 4: result += bh_find4_count(start, end, item); break;
+    case 8: result += bh_find8_count(start, end, item); break;
+    default:
+        for (; start < end; start += element)
+            result += !memcmp(start, item, element);
+    }
+
+    return result;
+}
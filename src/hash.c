@@ -0,0 +1,221 @@
+/*
+ * BHLib
+ *
+ * Copyright (c) 2024 Mikhail Romanko
+ */
+#include <bh/hash.h>
+#include <string.h>
+#include <stdint.h>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+#define BH_HASH_SECRET0 0x2d358dccaa6c78a5ull
+#define BH_HASH_SECRET1 0x8bb84b93962eacc9ull
+#define BH_HASH_SECRET2 0x4b33a62ed433d4a3ull
+#define BH_HASH_SECRET3 0x4d5a2da51de1aa47ull
+
+#if defined(__SIZEOF_INT128__)
+__extension__ typedef unsigned __int128 bh_hash_u128_t;
+#endif
+
+static BH_INLINE void bh_hash_mum(uint64_t *a,
+                                  uint64_t *b)
+{
+#if defined(__SIZEOF_INT128__)
+    bh_hash_u128_t result;
+
+    result = (bh_hash_u128_t)*a * *b;
+    *a = (uint64_t)result;
+    *b = (uint64_t)(result >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    *a = _umul128(*a, *b, b);
+#else
+    uint64_t ha, hb, la, lb, rh, rm0, rm1, rl, t, lo;
+    int carry;
+
+    /* Full 128-bit product from 32-bit halves */
+    ha = *a >> 32;
+    hb = *b >> 32;
+    la = (uint32_t)*a;
+    lb = (uint32_t)*b;
+    rh = ha * hb;
+    rm0 = ha * lb;
+    rm1 = hb * la;
+    rl = la * lb;
+    t = rl + (rm0 << 32);
+    carry = t < rl;
+    lo = t + (rm1 << 32);
+    carry += lo < t;
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+#endif
+}
+
+static BH_INLINE uint64_t bh_hash_mix(uint64_t a,
+                                      uint64_t b)
+{
+    bh_hash_mum(&a, &b);
+    return a ^ b;
+}
+
+static BH_INLINE uint64_t bh_hash_read8(const unsigned char *p)
+{
+    /* Compilers fold this into single load on little-endian targets */
+    return (uint64_t)p[0] | ((uint64_t)p[1] << 8) | ((uint64_t)p[2] << 16) |
+           ((uint64_t)p[3] << 24) | ((uint64_t)p[4] << 32) | ((uint64_t)p[5] << 40) |
+           ((uint64_t)p[6] << 48) | ((uint64_t)p[7] << 56);
+}
+
+static BH_INLINE uint64_t bh_hash_read4(const unsigned char *p)
+{
+    return (uint64_t)p[0] | ((uint64_t)p[1] << 8) | ((uint64_t)p[2] << 16) |
+           ((uint64_t)p[3] << 24);
+}
+
+static BH_INLINE size_t bh_hash_wy(const void *data,
+                                   size_t size,
+                                   uint64_t seed)
+{
+    const unsigned char *p;
+    uint64_t a, b, see1, see2;
+    size_t i;
+
+    p = (const unsigned char *)data;
+    seed ^= bh_hash_mix(seed ^ BH_HASH_SECRET0, BH_HASH_SECRET1);
+
+    if (size <= 16)
+    {
+        /* Short keys are read with overlapping loads */
+        if (size >= 4)
+        {
+            a = (bh_hash_read4(p) << 32) | bh_hash_read4(p + ((size >> 3) << 2));
+            b = (bh_hash_read4(p + size - 4) << 32) | bh_hash_read4(p + size - 4 - ((size >> 3) << 2));
+        }
+        else if (size)
+        {
+            a = ((uint64_t)p[0] << 16) | ((uint64_t)p[size >> 1] << 8) | p[size - 1];
+            b = 0;
+        }
+        else
+            a = b = 0;
+    }
+    else
+    {
+        i = size;
+        if (i > 48)
+        {
+            /* Three independent lanes to hide multiplication latency */
+            see1 = seed;
+            see2 = seed;
+            do
+            {
+                seed = bh_hash_mix(bh_hash_read8(p) ^ BH_HASH_SECRET1, bh_hash_read8(p + 8) ^ seed);
+                see1 = bh_hash_mix(bh_hash_read8(p + 16) ^ BH_HASH_SECRET2, bh_hash_read8(p + 24) ^ see1);
+                see2 = bh_hash_mix(bh_hash_read8(p + 32) ^ BH_HASH_SECRET3, bh_hash_read8(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+
+        while (i > 16)
+        {
+            seed = bh_hash_mix(bh_hash_read8(p) ^ BH_HASH_SECRET1, bh_hash_read8(p + 8) ^ seed);
+            p += 16;
+            i -= 16;
+        }
+
+        a = bh_hash_read8(p + i - 16);
+        b = bh_hash_read8(p + i - 8);
+    }
+
+    a ^= BH_HASH_SECRET1;
+    b ^= seed;
+    bh_hash_mum(&a, &b);
+    return (size_t)bh_hash_mix(a ^ BH_HASH_SECRET0 ^ size, b ^ BH_HASH_SECRET1);
+}
+
+size_t bh_hash_bytes(const void *data,
+                     size_t size,
+                     size_t seed)
+{
+    return bh_hash_wy(data, size, seed);
+}
+
+size_t bh_hash_string(const char *str,
+                      size_t seed)
+{
+    return bh_hash_wy(str, strlen(str), seed);
+}
+
+size_t bh_hash4(const void *key,
+                size_t seed)
+{
+    return bh_hash_wy(key, 4, seed);
+}
+
+size_t bh_hash8(const void *key,
+                size_t seed)
+{
+    return bh_hash_wy(key, 8, seed);
+}
+
+size_t bh_hash16(const void *key,
+                 size_t seed)
+{
+    return bh_hash_wy(key, 16, seed);
+}
+
+size_t bh_hash_key4(const void *key)
+{
+    return bh_hash_wy(key, 4, BH_HASH_SEED);
+}
+
+size_t bh_hash_key8(const void *key)
+{
+    return bh_hash_wy(key, 8, BH_HASH_SEED);
+}
+
+size_t bh_hash_key16(const void *key)
+{
+    return bh_hash_wy(key, 16, BH_HASH_SEED);
+}
+
+size_t bh_hash_key_string(const void *key)
+{
+    return bh_hash_string(*(const char * const *)key, BH_HASH_SEED);
+}
+
+int bh_compare_key4(const void *a,
+                    const void *b)
+{
+    uint32_t x, y;
+
+    memcpy(&x, a, sizeof(x));
+    memcpy(&y, b, sizeof(y));
+    return (x > y) - (x < y);
+}
+
+int bh_compare_key8(const void *a,
+                    const void *b)
+{
+    uint64_t x, y;
+
+    memcpy(&x, a, sizeof(x));
+    memcpy(&y, b, sizeof(y));
+    return (x > y) - (x < y);
+}
+
+int bh_compare_key16(const void *a,
+                     const void *b)
+{
+    return memcmp(a, b, 16);
+}
+
+int bh_compare_key_string(const void *a,
+                          const void *b)
+{
+    return strcmp(*(const char * const *)a, *(const char * const *)b);
+}
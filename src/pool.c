@@ -0,0 +1,282 @@
+/*
+ * BHLib
+ *
+ * Copyright (c) 2024 Mikhail Romanko
+ */
+#include <bh/pool.h>
+#include <string.h>
+
+#define BH_POOL_HEADER  ((sizeof(bh_pool_block_t) + 15) & ~(size_t)15)
+
+#define BH_POOL_NEXT(ptr) \
+    (*(void **)(ptr))
+
+static void bh_pool_lock(bh_pool_t *pool)
+{
+    if (pool->shared)
+        bh_mutex_lock(&pool->mutex);
+}
+
+static void bh_pool_unlock(bh_pool_t *pool)
+{
+    if (pool->shared)
+        bh_mutex_unlock(&pool->mutex);
+}
+
+static void *bh_pool_take(bh_pool_t *pool)
+{
+    bh_pool_block_t *block;
+    size_t size;
+    void *result;
+
+    /* Recycle object from the free list */
+    if (pool->free)
+    {
+        result = pool->free;
+        pool->free = BH_POOL_NEXT(result);
+        pool->count++;
+        return result;
+    }
+
+    /* Carve object from the block, allocate new block if needed */
+    if ((size_t)(pool->end - pool->current) < pool->size)
+    {
+        size = pool->block_size;
+        if (size < BH_POOL_HEADER + pool->size)
+            size = BH_POOL_HEADER + pool->size;
+
+        block = (bh_pool_block_t *)bh_alloc(pool->backing, size);
+        if (!block)
+            return NULL;
+
+        block->next = pool->blocks;
+        block->size = size;
+        pool->blocks = block;
+        pool->current = (char *)block + BH_POOL_HEADER;
+        pool->end = (char *)block + size;
+    }
+
+    result = pool->current;
+    pool->current += pool->size;
+    pool->count++;
+    return result;
+}
+
+static void bh_pool_give(bh_pool_t *pool,
+                         void *ptr)
+{
+    BH_POOL_NEXT(ptr) = pool->free;
+    pool->free = ptr;
+    pool->count--;
+}
+
+static void *bh_pool_cb_alloc(void *context,
+                              size_t size)
+{
+    bh_pool_t *pool;
+
+    pool = (bh_pool_t *)context;
+    if (size <= pool->size)
+        return bh_pool_alloc(pool);
+
+    return bh_alloc(pool->backing, size);
+}
+
+static void *bh_pool_cb_realloc(void *context,
+                                void *ptr,
+                                size_t old_size,
+                                size_t size)
+{
+    bh_pool_t *pool;
+    void *result;
+
+    pool = (bh_pool_t *)context;
+
+    /* Both sizes are served by the same allocator */
+    if (ptr && old_size <= pool->size && size <= pool->size)
+        return ptr;
+    if (ptr && old_size > pool->size && size > pool->size)
+        return bh_realloc(pool->backing, ptr, old_size, size);
+
+    /* Move between pool and backing allocator */
+    result = bh_pool_cb_alloc(context, size);
+    if (result && ptr)
+    {
+        memcpy(result, ptr, (old_size < size) ? (old_size) : (size));
+        if (old_size <= pool->size)
+            bh_pool_free(pool, ptr);
+        else
+            bh_free(pool->backing, ptr, old_size);
+    }
+
+    return result;
+}
+
+static void bh_pool_cb_free(void *context,
+                            void *ptr,
+                            size_t size)
+{
+    bh_pool_t *pool;
+
+    pool = (bh_pool_t *)context;
+    if (size <= pool->size)
+        bh_pool_free(pool, ptr);
+    else
+        bh_free(pool->backing, ptr, size);
+}
+
+void bh_pool_init(bh_pool_t *pool,
+                  size_t size,
+                  size_t block_size,
+                  const bh_allocator_t *backing)
+{
+    memset(pool, 0, sizeof(*pool));
+
+    /* Object should fit free list pointer and keep pointer alignment */
+    if (size < sizeof(void *))
+        size = sizeof(void *);
+    size = (size + sizeof(void *) - 1) / sizeof(void *) * sizeof(void *);
+
+    pool->size = size;
+    pool->block_size = (block_size) ? (block_size) : (BH_POOL_BLOCK);
+    pool->backing = backing;
+    pool->allocator.alloc = bh_pool_cb_alloc;
+    pool->allocator.realloc = bh_pool_cb_realloc;
+    pool->allocator.free = bh_pool_cb_free;
+    pool->allocator.context = pool;
+}
+
+int bh_pool_init_shared(bh_pool_t *pool,
+                        size_t size,
+                        size_t block_size,
+                        const bh_allocator_t *backing)
+{
+    bh_pool_init(pool, size, block_size, backing);
+
+#ifdef BH_USE_THREADS
+    if (bh_mutex_init(&pool->mutex))
+        return -1;
+    pool->shared = 1;
+#endif
+
+    return 0;
+}
+
+void bh_pool_destroy(bh_pool_t *pool)
+{
+    bh_pool_block_t *block;
+
+    while (pool->blocks)
+    {
+        block = pool->blocks;
+        pool->blocks = block->next;
+        bh_free(pool->backing, block, block->size);
+    }
+
+    if (pool->shared)
+        bh_mutex_destroy(&pool->mutex);
+}
+
+void *bh_pool_alloc(bh_pool_t *pool)
+{
+    void *result;
+
+    bh_pool_lock(pool);
+    result = bh_pool_take(pool);
+    bh_pool_unlock(pool);
+
+    return result;
+}
+
+void bh_pool_free(bh_pool_t *pool,
+                  void *ptr)
+{
+    if (!ptr)
+        return;
+
+    bh_pool_lock(pool);
+    bh_pool_give(pool, ptr);
+    bh_pool_unlock(pool);
+}
+
+const bh_allocator_t *bh_pool_allocator(bh_pool_t *pool)
+{
+    return &pool->allocator;
+}
+
+void bh_pool_cache_init(bh_pool_cache_t *cache,
+                        bh_pool_t *pool)
+{
+    cache->pool = pool;
+    cache->free = NULL;
+    cache->size = 0;
+}
+
+static void bh_pool_cache_flush(bh_pool_cache_t *cache,
+                                size_t count)
+{
+    void *ptr;
+
+    /* Return objects to the pool under single lock */
+    bh_pool_lock(cache->pool);
+    while (count-- && cache->free)
+    {
+        ptr = cache->free;
+        cache->free = BH_POOL_NEXT(ptr);
+        cache->size--;
+        bh_pool_give(cache->pool, ptr);
+    }
+    bh_pool_unlock(cache->pool);
+}
+
+void bh_pool_cache_destroy(bh_pool_cache_t *cache)
+{
+    bh_pool_cache_flush(cache, cache->size);
+}
+
+void *bh_pool_cache_alloc(bh_pool_cache_t *cache)
+{
+    void *ptr;
+    size_t i;
+
+    /* Take batch of objects from the pool under single lock */
+    if (!cache->free)
+    {
+        bh_pool_lock(cache->pool);
+        for (i = 0; i < BH_POOL_CACHE; i++)
+        {
+            ptr = bh_pool_take(cache->pool);
+            if (!ptr)
+                break;
+
+            BH_POOL_NEXT(ptr) = cache->free;
+            cache->free = ptr;
+            cache->size++;
+        }
+        bh_pool_unlock(cache->pool);
+
+        if (!cache->free)
+            return NULL;
+    }
+
+    /* Objects in the cache are counted as allocated by the pool */
+    ptr = cache->free;
+    cache->free = BH_POOL_NEXT(ptr);
+    cache->size--;
+    return ptr;
+}
+
+void bh_pool_cache_free(bh_pool_cache_t *cache,
+                        void *ptr)
+{
+    if (!ptr)
+        return;
+
+    BH_POOL_NEXT(ptr) = cache->free;
+    cache->free = ptr;
+    cache->size++;
+
+    /* Keep cache bounded */
+    if (cache->size >= 2 * BH_POOL_CACHE)
+        bh_pool_cache_flush(cache, BH_POOL_CACHE);
+}
@@ -0,0 +1,1211 @@
+/*
+ * BHLib
+ *
+ * Copyright (c) 2024 Mikhail Romanko
+ */
+#include <bh/roaring.h>
+#include <string.h>
+
+#define BH_ROARING_ARRAY    0
+#define BH_ROARING_BITMAP   1
+#define BH_ROARING_RUN      2
+
+#define BH_ROARING_WORDS    1024
+#define BH_ROARING_BITS     65536
+#define BH_ROARING_GALLOP   32
+
+/*
+ * Array container stores sorted values, run container stores sorted pairs
+ * of the first and the last value of each run. Capacity is measured in
+ * 16-bit items for both of them.
+ */
+typedef struct
+{
+    void *data;
+    size_t size;
+    size_t runs;
+    size_t capacity;
+    uint16_t key;
+    uint16_t type;
+} bh_roaring_chunk_t;
+
+#define BH_ROARING_CHUNK(roaring, index) \
+    ((bh_roaring_chunk_t *)bh_array_data(&(roaring)->chunks) + (index))
+
+#define BH_ROARING_ALLOCATOR(roaring) \
+    ((roaring)->chunks.allocator)
+
+static BH_INLINE size_t bh_roaring_ctz(uint64_t word)
+{
+#if defined(__GNUC__)
+    return (size_t)__builtin_ctzll(word);
+#else
+    size_t result;
+
+    for (result = 0; !(word & 1); word >>= 1)
+        result++;
+    return result;
+#endif
+}
+
+static BH_INLINE size_t bh_roaring_popcount_word(uint64_t word)
+{
+#if defined(__GNUC__)
+    return (size_t)__builtin_popcountll(word);
+#else
+    word = word - ((word >> 1) & 0x5555555555555555ull);
+    word = (word & 0x3333333333333333ull) + ((word >> 2) & 0x3333333333333333ull);
+    word = (word + (word >> 4)) & 0x0f0f0f0f0f0f0f0full;
+    return (size_t)((word * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+/* Bitmap containers are processed with bh_bitset_t kernels */
+static void bh_roaring_view(bh_bitset_t *view,
+                            const uint64_t *words)
+{
+    view->data = (void *)words;
+    view->size = BH_ROARING_BITS;
+    view->capacity = BH_ROARING_WORDS;
+    view->allocator = NULL;
+}
+
+static size_t bh_roaring_popcount(const uint64_t *words)
+{
+    bh_bitset_t view;
+
+    bh_roaring_view(&view, words);
+    return bh_bitset_count(&view);
+}
+
+static size_t bh_roaring_bytes(const bh_roaring_chunk_t *chunk)
+{
+    if (chunk->type == BH_ROARING_BITMAP)
+        return BH_ROARING_WORDS * sizeof(uint64_t);
+
+    return chunk->capacity * sizeof(uint16_t);
+}
+
+static int bh_roaring_chunk_alloc(const bh_allocator_t *allocator,
+                                  bh_roaring_chunk_t *chunk,
+                                  uint16_t type,
+                                  size_t capacity)
+{
+    chunk->type = type;
+    chunk->capacity = (type == BH_ROARING_BITMAP) ? (0) : ((capacity) ? (capacity) : (1));
+    chunk->data = bh_alloc(allocator, bh_roaring_bytes(chunk));
+
+    return (chunk->data) ? (0) : (-1);
+}
+
+static void bh_roaring_chunk_free(const bh_allocator_t *allocator,
+                                  bh_roaring_chunk_t *chunk)
+{
+    bh_free(allocator, chunk->data, bh_roaring_bytes(chunk));
+    chunk->data = NULL;
+    chunk->capacity = 0;
+}
+
+static size_t bh_roaring_lower(const uint16_t *data,
+                               size_t size,
+                               uint16_t value)
+{
+    size_t low, high, mid;
+
+    low = 0;
+    high = size;
+    while (low < high)
+    {
+        mid = low + (high - low) / 2;
+        if (data[mid] < value)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return low;
+}
+
+static size_t bh_roaring_gallop(const uint16_t *data,
+                                size_t from,
+                                size_t size,
+                                uint16_t value)
+{
+    size_t low, step, high;
+
+    if (from >= size || data[from] >= value)
+        return from;
+
+    /* Exponential search for the window, then binary search inside */
+    low = from;
+    step = 1;
+    while (low + step < size && data[low + step] < value)
+    {
+        low += step;
+        step <<= 1;
+    }
+    high = (low + step < size) ? (low + step) : (size);
+
+    return low + 1 + bh_roaring_lower(data + low + 1, high - low - 1, value);
+}
+
+static int bh_roaring_run_contains(const uint16_t *data,
+                                   size_t runs,
+                                   uint16_t value)
+{
+    size_t low, high, mid;
+
+    /* Find first run, that starts after the value */
+    low = 0;
+    high = runs;
+    while (low < high)
+    {
+        mid = low + (high - low) / 2;
+        if (data[2 * mid] <= value)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return low && value <= data[2 * (low - 1) + 1];
+}
+
+static int bh_roaring_chunk_contains(const bh_roaring_chunk_t *chunk,
+                                     uint16_t value)
+{
+    const uint16_t *data;
+    size_t index;
+
+    switch (chunk->type)
+    {
+    case BH_ROARING_BITMAP:
+        return (((const uint64_t *)chunk->data)[value >> 6] >> (value & 63)) & 1;
+
+    case BH_ROARING_RUN:
+        return bh_roaring_run_contains((const uint16_t *)chunk->data, chunk->runs, value);
+
+    default:
+        data = (const uint16_t *)chunk->data;
+        index = bh_roaring_lower(data, chunk->size, value);
+        return index < chunk->size && data[index] == value;
+    }
+}
+
+static void bh_roaring_fill(uint64_t *words,
+                            size_t first,
+                            size_t last)
+{
+    uint64_t first_mask, last_mask;
+    size_t i;
+
+    first_mask = ~(uint64_t)0 << (first & 63);
+    last_mask = ~(uint64_t)0 >> (63 - (last & 63));
+
+    if (first >> 6 == last >> 6)
+    {
+        words[first >> 6] |= first_mask & last_mask;
+        return;
+    }
+
+    words[first >> 6] |= first_mask;
+    for (i = (first >> 6) + 1; i < last >> 6; i++)
+        words[i] = ~(uint64_t)0;
+    words[last >> 6] |= last_mask;
+}
+
+/* Add values of the chunk to the bitmap words */
+static void bh_roaring_words(const bh_roaring_chunk_t *chunk,
+                             uint64_t *words)
+{
+    const uint16_t *data;
+    bh_bitset_t view, other;
+    size_t i;
+
+    data = (const uint16_t *)chunk->data;
+    switch (chunk->type)
+    {
+    case BH_ROARING_BITMAP:
+        bh_roaring_view(&view, words);
+        bh_roaring_view(&other, (const uint64_t *)chunk->data);
+        bh_bitset_or(&view, &other);
+        break;
+
+    case BH_ROARING_RUN:
+        for (i = 0; i < chunk->runs; i++)
+            bh_roaring_fill(words, data[2 * i], data[2 * i + 1]);
+        break;
+
+    default:
+        for (i = 0; i < chunk->size; i++)
+            words[data[i] >> 6] |= (uint64_t)1 << (data[i] & 63);
+        break;
+    }
+}
+
+/* Create array or bitmap container from the bitmap words */
+static int bh_roaring_chunk_from(const bh_allocator_t *allocator,
+                                 bh_roaring_chunk_t *chunk,
+                                 const uint64_t *words,
+                                 size_t size)
+{
+    uint16_t *data;
+    uint64_t word;
+    size_t i, j;
+
+    chunk->size = size;
+    chunk->runs = 0;
+
+    if (size > BH_ROARING_ARRAY_MAX)
+    {
+        if (bh_roaring_chunk_alloc(allocator, chunk, BH_ROARING_BITMAP, 0))
+            return -1;
+
+        memcpy(chunk->data, words, BH_ROARING_WORDS * sizeof(uint64_t));
+        return 0;
+    }
+
+    if (bh_roaring_chunk_alloc(allocator, chunk, BH_ROARING_ARRAY, size))
+        return -1;
+
+    data = (uint16_t *)chunk->data;
+    for (i = 0, j = 0; i < BH_ROARING_WORDS && j < size; i++)
+    {
+        for (word = words[i]; word; word &= word - 1)
+            data[j++] = (uint16_t)(i * 64 + bh_roaring_ctz(word));
+    }
+
+    return 0;
+}
+
+/* Convert chunk to array or bitmap container depending on its size */
+static int bh_roaring_normalize(const bh_allocator_t *allocator,
+                                bh_roaring_chunk_t *chunk)
+{
+    uint64_t buffer[BH_ROARING_WORDS];
+    bh_roaring_chunk_t result;
+    const uint64_t *words;
+
+    if (chunk->type == BH_ROARING_BITMAP)
+    {
+        words = (const uint64_t *)chunk->data;
+    }
+    else
+    {
+        memset(buffer, 0, sizeof(buffer));
+        bh_roaring_words(chunk, buffer);
+        words = buffer;
+    }
+
+    result.key = chunk->key;
+    if (bh_roaring_chunk_from(allocator, &result, words, chunk->size))
+        return -1;
+
+    bh_roaring_chunk_free(allocator, chunk);
+    *chunk = result;
+    return 0;
+}
+
+static int bh_roaring_to_bitmap(const bh_allocator_t *allocator,
+                                bh_roaring_chunk_t *chunk)
+{
+    bh_roaring_chunk_t result;
+
+    result = *chunk;
+    if (bh_roaring_chunk_alloc(allocator, &result, BH_ROARING_BITMAP, 0))
+        return -1;
+
+    memset(result.data, 0, BH_ROARING_WORDS * sizeof(uint64_t));
+    bh_roaring_words(chunk, (uint64_t *)result.data);
+    bh_roaring_chunk_free(allocator, chunk);
+    *chunk = result;
+    return 0;
+}
+
+static int bh_roaring_chunk_clone(const bh_allocator_t *allocator,
+                                  bh_roaring_chunk_t *chunk,
+                                  const bh_roaring_chunk_t *from)
+{
+    size_t capacity;
+
+    *chunk = *from;
+    capacity = (from->type == BH_ROARING_RUN) ? (from->runs * 2) : (from->size);
+    if (bh_roaring_chunk_alloc(allocator, chunk, from->type, capacity))
+        return -1;
+
+    memcpy(chunk->data, from->data, bh_roaring_bytes(chunk));
+    return 0;
+}
+
+static size_t bh_roaring_intersect(const uint16_t *a,
+                                   size_t asize,
+                                   const uint16_t *b,
+                                   size_t bsize,
+                                   uint16_t *out)
+{
+    const uint16_t *swap;
+    size_t i, j, result, tmp;
+
+    if (asize > bsize)
+    {
+        swap = a; a = b; b = swap;
+        tmp = asize; asize = bsize; bsize = tmp;
+    }
+
+    /* Skewed sizes - gallop through the larger array */
+    result = 0;
+    if (asize * BH_ROARING_GALLOP < bsize)
+    {
+        for (i = 0, j = 0; i < asize; i++)
+        {
+            j = bh_roaring_gallop(b, j, bsize, a[i]);
+            if (j >= bsize)
+                break;
+            if (b[j] == a[i])
+                out[result++] = a[i];
+        }
+        return result;
+    }
+
+    i = j = 0;
+    while (i < asize && j < bsize)
+    {
+        if (a[i] < b[j])
+            i++;
+        else if (b[j] < a[i])
+            j++;
+        else
+        {
+            out[result++] = a[i];
+            i++;
+            j++;
+        }
+    }
+
+    return result;
+}
+
+static size_t bh_roaring_union(const uint16_t *a,
+                               size_t asize,
+                               const uint16_t *b,
+                               size_t bsize,
+                               uint16_t *out)
+{
+    size_t i, j, result;
+
+    i = j = result = 0;
+    while (i < asize && j < bsize)
+    {
+        if (a[i] < b[j])
+            out[result++] = a[i++];
+        else if (b[j] < a[i])
+            out[result++] = b[j++];
+        else
+        {
+            out[result++] = a[i];
+            i++;
+            j++;
+        }
+    }
+
+    while (i < asize)
+        out[result++] = a[i++];
+    while (j < bsize)
+        out[result++] = b[j++];
+
+    return result;
+}
+
+static int bh_roaring_chunk_and(const bh_allocator_t *allocator,
+                                bh_roaring_chunk_t *chunk,
+                                const bh_roaring_chunk_t *a,
+                                const bh_roaring_chunk_t *b)
+{
+    uint64_t buffer[BH_ROARING_WORDS], other[BH_ROARING_WORDS];
+    bh_bitset_t view, mask;
+    const bh_roaring_chunk_t *swap;
+    const uint16_t *data;
+    uint16_t *out;
+    size_t i;
+
+    chunk->key = a->key;
+    chunk->runs = 0;
+    chunk->size = 0;
+
+    /* Make array container the first one */
+    if (b->type == BH_ROARING_ARRAY)
+    {
+        swap = a; a = b; b = swap;
+    }
+
+    if (a->type == BH_ROARING_ARRAY)
+    {
+        if (bh_roaring_chunk_alloc(allocator, chunk, BH_ROARING_ARRAY, a->size))
+            return -1;
+
+        data = (const uint16_t *)a->data;
+        out = (uint16_t *)chunk->data;
+        if (b->type == BH_ROARING_ARRAY)
+        {
+            chunk->size = bh_roaring_intersect(data, a->size, (const uint16_t *)b->data, b->size, out);
+        }
+        else
+        {
+            for (i = 0; i < a->size; i++)
+                if (bh_roaring_chunk_contains(b, data[i]))
+                    out[chunk->size++] = data[i];
+        }
+        return 0;
+    }
+
+    /* Bitmap and run containers are intersected as bitmaps */
+    memset(buffer, 0, sizeof(buffer));
+    bh_roaring_words(a, buffer);
+    bh_roaring_view(&view, buffer);
+
+    if (b->type == BH_ROARING_BITMAP)
+    {
+        bh_roaring_view(&mask, (const uint64_t *)b->data);
+    }
+    else
+    {
+        memset(other, 0, sizeof(other));
+        bh_roaring_words(b, other);
+        bh_roaring_view(&mask, other);
+    }
+
+    bh_bitset_and(&view, &mask);
+    return bh_roaring_chunk_from(allocator, chunk, buffer, bh_bitset_count(&view));
+}
+
+static int bh_roaring_chunk_or(const bh_allocator_t *allocator,
+                               bh_roaring_chunk_t *chunk,
+                               const bh_roaring_chunk_t *a,
+                               const bh_roaring_chunk_t *b)
+{
+    uint64_t buffer[BH_ROARING_WORDS];
+
+    chunk->key = a->key;
+    chunk->runs = 0;
+
+    /* Small arrays are merged, everything else is combined as bitmaps */
+    if (a->type == BH_ROARING_ARRAY && b->type == BH_ROARING_ARRAY &&
+        a->size + b->size <= BH_ROARING_ARRAY_MAX)
+    {
+        if (bh_roaring_chunk_alloc(allocator, chunk, BH_ROARING_ARRAY, a->size + b->size))
+            return -1;
+
+        chunk->size = bh_roaring_union((const uint16_t *)a->data, a->size,
+                                       (const uint16_t *)b->data, b->size,
+                                       (uint16_t *)chunk->data);
+        return 0;
+    }
+
+    memset(buffer, 0, sizeof(buffer));
+    bh_roaring_words(a, buffer);
+    bh_roaring_words(b, buffer);
+    return bh_roaring_chunk_from(allocator, chunk, buffer, bh_roaring_popcount(buffer));
+}
+
+static size_t bh_roaring_runs(const bh_roaring_chunk_t *chunk)
+{
+    const uint16_t *data;
+    const uint64_t *words;
+    uint64_t carry;
+    size_t i, result;
+
+    switch (chunk->type)
+    {
+    case BH_ROARING_BITMAP:
+        /* Count bits, that start runs (previous bit is cleared) */
+        words = (const uint64_t *)chunk->data;
+        for (i = 0, result = 0, carry = 0; i < BH_ROARING_WORDS; i++)
+        {
+            result += bh_roaring_popcount_word(words[i] & ~((words[i] << 1) | carry));
+            carry = words[i] >> 63;
+        }
+        return result;
+
+    case BH_ROARING_RUN:
+        return chunk->runs;
+
+    default:
+        data = (const uint16_t *)chunk->data;
+        for (i = 1, result = (chunk->size) ? (1) : (0); i < chunk->size; i++)
+            if (data[i] != data[i - 1] + 1)
+                result++;
+        return result;
+    }
+}
+
+static int bh_roaring_to_runs(const bh_allocator_t *allocator,
+                              bh_roaring_chunk_t *chunk,
+                              size_t runs)
+{
+    bh_roaring_chunk_t result;
+    const uint16_t *data;
+    const uint64_t *words;
+    uint16_t *out, value;
+    uint64_t word;
+    size_t i, j;
+
+    result = *chunk;
+    result.runs = runs;
+    if (bh_roaring_chunk_alloc(allocator, &result, BH_ROARING_RUN, runs * 2))
+        return -1;
+
+    /* Extend last run or start a new one for each value */
+    out = (uint16_t *)result.data;
+    j = 0;
+    if (chunk->type == BH_ROARING_BITMAP)
+    {
+        words = (const uint64_t *)chunk->data;
+        for (i = 0; i < BH_ROARING_WORDS; i++)
+        {
+            for (word = words[i]; word; word &= word - 1)
+            {
+                value = (uint16_t)(i * 64 + bh_roaring_ctz(word));
+                if (j && out[2 * j - 1] + 1 == value)
+                    out[2 * j - 1] = value;
+                else
+                {
+                    out[2 * j] = out[2 * j + 1] = value;
+                    j++;
+                }
+            }
+        }
+    }
+    else
+    {
+        data = (const uint16_t *)chunk->data;
+        for (i = 0; i < chunk->size; i++)
+        {
+            if (j && out[2 * j - 1] + 1 == data[i])
+                out[2 * j - 1] = data[i];
+            else
+            {
+                out[2 * j] = out[2 * j + 1] = data[i];
+                j++;
+            }
+        }
+    }
+
+    bh_roaring_chunk_free(allocator, chunk);
+    *chunk = result;
+    return 0;
+}
+
+static bh_roaring_chunk_t *bh_roaring_find(const bh_roaring_t *roaring,
+                                           uint16_t key,
+                                           size_t *index)
+{
+    bh_roaring_chunk_t *chunks;
+    size_t low, high, mid;
+
+    chunks = (bh_roaring_chunk_t *)bh_array_data(&roaring->chunks);
+    low = 0;
+    high = bh_array_size(&roaring->chunks);
+    while (low < high)
+    {
+        mid = low + (high - low) / 2;
+        if (chunks[mid].key < key)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    if (index)
+        *index = low;
+
+    if (low < bh_array_size(&roaring->chunks) && chunks[low].key == key)
+        return chunks + low;
+
+    return NULL;
+}
+
+void bh_roaring_init(bh_roaring_t *roaring)
+{
+    bh_roaring_init_alloc(roaring, NULL);
+}
+
+void bh_roaring_init_alloc(bh_roaring_t *roaring,
+                           const bh_allocator_t *allocator)
+{
+    bh_array_init_alloc(&roaring->chunks, sizeof(bh_roaring_chunk_t), allocator);
+}
+
+void bh_roaring_destroy(bh_roaring_t *roaring)
+{
+    bh_roaring_clear(roaring);
+    bh_array_destroy(&roaring->chunks);
+}
+
+void bh_roaring_clear(bh_roaring_t *roaring)
+{
+    size_t i;
+
+    for (i = 0; i < bh_array_size(&roaring->chunks); i++)
+        bh_roaring_chunk_free(BH_ROARING_ALLOCATOR(roaring), BH_ROARING_CHUNK(roaring, i));
+
+    bh_array_clear(&roaring->chunks);
+}
+
+int bh_roaring_add(bh_roaring_t *roaring,
+                   uint32_t value)
+{
+    const bh_allocator_t *allocator;
+    bh_roaring_chunk_t *chunk;
+    uint16_t low, *data;
+    uint64_t *words;
+    size_t index, capacity;
+
+    allocator = BH_ROARING_ALLOCATOR(roaring);
+    low = (uint16_t)(value & 0xFFFF);
+    chunk = bh_roaring_find(roaring, (uint16_t)(value >> 16), &index);
+
+    /* Create new chunk with an array container */
+    if (!chunk)
+    {
+        chunk = (bh_roaring_chunk_t *)bh_array_insert(&roaring->chunks, index);
+        if (!chunk)
+            return -1;
+
+        memset(chunk, 0, sizeof(*chunk));
+        chunk->key = (uint16_t)(value >> 16);
+        if (bh_roaring_chunk_alloc(allocator, chunk, BH_ROARING_ARRAY, 4))
+        {
+            bh_array_remove(&roaring->chunks, chunk);
+            return -1;
+        }
+    }
+
+    /* Run containers are converted on modification */
+    if (chunk->type == BH_ROARING_RUN)
+    {
+        if (bh_roaring_chunk_contains(chunk, low))
+            return 0;
+        if (bh_roaring_normalize(allocator, chunk))
+            return -1;
+    }
+
+    if (chunk->type == BH_ROARING_ARRAY)
+    {
+        data = (uint16_t *)chunk->data;
+        index = bh_roaring_lower(data, chunk->size, low);
+        if (index < chunk->size && data[index] == low)
+            return 0;
+
+        if (chunk->size < BH_ROARING_ARRAY_MAX)
+        {
+            if (chunk->size == chunk->capacity)
+            {
+                capacity = chunk->capacity * 2;
+                if (capacity > BH_ROARING_ARRAY_MAX)
+                    capacity = BH_ROARING_ARRAY_MAX;
+
+                data = (uint16_t *)bh_realloc(allocator, chunk->data,
+                                              chunk->capacity * sizeof(uint16_t),
+                                              capacity * sizeof(uint16_t));
+                if (!data)
+                    return -1;
+
+                chunk->data = data;
+                chunk->capacity = capacity;
+            }
+
+            memmove(data + index + 1, data + index, (chunk->size - index) * sizeof(uint16_t));
+            data[index] = low;
+            chunk->size++;
+            return 0;
+        }
+
+        /* Array is full, switch to bitmap */
+        if (bh_roaring_to_bitmap(allocator, chunk))
+            return -1;
+    }
+
+    words = (uint64_t *)chunk->data;
+    if (!((words[low >> 6] >> (low & 63)) & 1))
+    {
+        words[low >> 6] |= (uint64_t)1 << (low & 63);
+        chunk->size++;
+    }
+
+    return 0;
+}
+
+int bh_roaring_remove(bh_roaring_t *roaring,
+                      uint32_t value)
+{
+    const bh_allocator_t *allocator;
+    bh_roaring_chunk_t *chunk;
+    uint16_t low, *data;
+    uint64_t *words;
+    size_t index;
+
+    allocator = BH_ROARING_ALLOCATOR(roaring);
+    low = (uint16_t)(value & 0xFFFF);
+    chunk = bh_roaring_find(roaring, (uint16_t)(value >> 16), NULL);
+    if (!chunk || !bh_roaring_chunk_contains(chunk, low))
+        return 0;
+
+    if (chunk->type == BH_ROARING_RUN)
+        if (bh_roaring_normalize(allocator, chunk))
+            return -1;
+
+    if (chunk->type == BH_ROARING_BITMAP)
+    {
+        words = (uint64_t *)chunk->data;
+        words[low >> 6] &= ~((uint64_t)1 << (low & 63));
+        chunk->size--;
+
+        /* Switch back to array, value is already removed on failure */
+        if (chunk->size <= BH_ROARING_ARRAY_MAX)
+            bh_roaring_normalize(allocator, chunk);
+    }
+    else
+    {
+        data = (uint16_t *)chunk->data;
+        index = bh_roaring_lower(data, chunk->size, low);
+        memmove(data + index, data + index + 1, (chunk->size - index - 1) * sizeof(uint16_t));
+        chunk->size--;
+    }
+
+    if (!chunk->size)
+    {
+        bh_roaring_chunk_free(allocator, chunk);
+        bh_array_remove(&roaring->chunks, chunk);
+    }
+
+    return 0;
+}
+
+int bh_roaring_contains(const bh_roaring_t *roaring,
+                        uint32_t value)
+{
+    const bh_roaring_chunk_t *chunk;
+
+    chunk = bh_roaring_find(roaring, (uint16_t)(value >> 16), NULL);
+    if (!chunk)
+        return 0;
+
+    return bh_roaring_chunk_contains(chunk, (uint16_t)(value & 0xFFFF));
+}
+
+size_t bh_roaring_count(const bh_roaring_t *roaring)
+{
+    size_t i, result;
+
+    for (i = 0, result = 0; i < bh_array_size(&roaring->chunks); i++)
+        result += BH_ROARING_CHUNK(roaring, i)->size;
+
+    return result;
+}
+
+int bh_roaring_optimize(bh_roaring_t *roaring)
+{
+    const bh_allocator_t *allocator;
+    bh_roaring_chunk_t *chunk;
+    size_t i, runs, plain;
+
+    allocator = BH_ROARING_ALLOCATOR(roaring);
+    for (i = 0; i < bh_array_size(&roaring->chunks); i++)
+    {
+        chunk = BH_ROARING_CHUNK(roaring, i);
+        runs = bh_roaring_runs(chunk);
+        plain = (chunk->size > BH_ROARING_ARRAY_MAX) ? (BH_ROARING_WORDS * 4) : (chunk->size);
+
+        /* Compare sizes in 16-bit items */
+        if (chunk->type == BH_ROARING_RUN && runs * 2 >= plain)
+        {
+            if (bh_roaring_normalize(allocator, chunk))
+                return -1;
+        }
+        else if (chunk->type != BH_ROARING_RUN && runs * 2 < plain)
+        {
+            if (bh_roaring_to_runs(allocator, chunk, runs))
+                return -1;
+        }
+    }
+
+    return 0;
+}
+
+size_t bh_roaring_to_array(const bh_roaring_t *roaring,
+                           uint32_t *out)
+{
+    const bh_roaring_chunk_t *chunk;
+    const uint16_t *data;
+    const uint64_t *words;
+    uint32_t base, value;
+    uint64_t word;
+    size_t i, j, result;
+
+    for (i = 0, result = 0; i < bh_array_size(&roaring->chunks); i++)
+    {
+        chunk = BH_ROARING_CHUNK(roaring, i);
+        base = (uint32_t)chunk->key << 16;
+        data = (const uint16_t *)chunk->data;
+
+        switch (chunk->type)
+        {
+        case BH_ROARING_BITMAP:
+            words = (const uint64_t *)chunk->data;
+            for (j = 0; j < BH_ROARING_WORDS; j++)
+                for (word = words[j]; word; word &= word - 1)
+                    out[result++] = base | (uint32_t)(j * 64 + bh_roaring_ctz(word));
+            break;
+
+        case BH_ROARING_RUN:
+            for (j = 0; j < chunk->runs; j++)
+                for (value = data[2 * j]; value <= data[2 * j + 1]; value++)
+                    out[result++] = base | value;
+            break;
+
+        default:
+            for (j = 0; j < chunk->size; j++)
+                out[result++] = base | data[j];
+            break;
+        }
+    }
+
+    return result;
+}
+
+static void bh_roaring_replace(bh_roaring_t *roaring,
+                               bh_roaring_t *result)
+{
+    bh_roaring_destroy(roaring);
+    *roaring = *result;
+}
+
+int bh_roaring_and(bh_roaring_t *out,
+                   const bh_roaring_t *a,
+                   const bh_roaring_t *b)
+{
+    const bh_allocator_t *allocator;
+    const bh_roaring_chunk_t *x, *y;
+    bh_roaring_chunk_t *chunk;
+    bh_roaring_t result;
+    size_t i, j;
+
+    allocator = BH_ROARING_ALLOCATOR(out);
+    bh_roaring_init_alloc(&result, allocator);
+
+    i = j = 0;
+    while (i < bh_array_size(&a->chunks) && j < bh_array_size(&b->chunks))
+    {
+        x = BH_ROARING_CHUNK(a, i);
+        y = BH_ROARING_CHUNK(b, j);
+        if (x->key < y->key)
+        {
+            i++;
+            continue;
+        }
+        else if (y->key < x->key)
+        {
+            j++;
+            continue;
+        }
+
+        chunk = (bh_roaring_chunk_t *)bh_array_insert(&result.chunks, bh_array_size(&result.chunks));
+        if (!chunk)
+            goto fail;
+
+        if (bh_roaring_chunk_and(allocator, chunk, x, y))
+        {
+            bh_array_resize(&result.chunks, bh_array_size(&result.chunks) - 1);
+            goto fail;
+        }
+
+        /* Skip empty chunks */
+        if (!chunk->size)
+        {
+            bh_roaring_chunk_free(allocator, chunk);
+            bh_array_resize(&result.chunks, bh_array_size(&result.chunks) - 1);
+        }
+
+        i++;
+        j++;
+    }
+
+    bh_roaring_replace(out, &result);
+    return 0;
+
+fail:
+    bh_roaring_destroy(&result);
+    return -1;
+}
+
+int bh_roaring_or(bh_roaring_t *out,
+                  const bh_roaring_t *a,
+                  const bh_roaring_t *b)
+{
+    const bh_allocator_t *allocator;
+    const bh_roaring_chunk_t *x, *y;
+    bh_roaring_chunk_t *chunk;
+    bh_roaring_t result;
+    size_t i, j;
+    int status;
+
+    allocator = BH_ROARING_ALLOCATOR(out);
+    bh_roaring_init_alloc(&result, allocator);
+    if (bh_array_reserve(&result.chunks, bh_array_size(&a->chunks) + bh_array_size(&b->chunks)))
+        return -1;
+
+    i = j = 0;
+    while (i < bh_array_size(&a->chunks) || j < bh_array_size(&b->chunks))
+    {
+        x = (i < bh_array_size(&a->chunks)) ? (BH_ROARING_CHUNK(a, i)) : (NULL);
+        y = (j < bh_array_size(&b->chunks)) ? (BH_ROARING_CHUNK(b, j)) : (NULL);
+
+        chunk = (bh_roaring_chunk_t *)bh_array_insert(&result.chunks, bh_array_size(&result.chunks));
+        if (!chunk)
+            goto fail;
+
+        /* Chunks present in one bitmap only are copied */
+        if (x && (!y || x->key < y->key))
+        {
+            status = bh_roaring_chunk_clone(allocator, chunk, x);
+            i++;
+        }
+        else if (!x || y->key < x->key)
+        {
+            status = bh_roaring_chunk_clone(allocator, chunk, y);
+            j++;
+        }
+        else
+        {
+            status = bh_roaring_chunk_or(allocator, chunk, x, y);
+            i++;
+            j++;
+        }
+
+        if (status)
+        {
+            bh_array_resize(&result.chunks, bh_array_size(&result.chunks) - 1);
+            goto fail;
+        }
+    }
+
+    bh_roaring_replace(out, &result);
+    return 0;
+
+fail:
+    bh_roaring_destroy(&result);
+    return -1;
+}
+
+static size_t bh_roaring_payload(const bh_roaring_chunk_t *chunk)
+{
+    switch (chunk->type)
+    {
+    case BH_ROARING_BITMAP:
+        return BH_ROARING_WORDS * sizeof(uint64_t);
+
+    case BH_ROARING_RUN:
+        return chunk->runs * 2 * sizeof(uint16_t);
+
+    default:
+        return chunk->size * sizeof(uint16_t);
+    }
+}
+
+static unsigned char *bh_roaring_put(unsigned char *p,
+                                     uint64_t value,
+                                     size_t size)
+{
+    size_t i;
+
+    for (i = 0; i < size; i++)
+        p[i] = (unsigned char)(value >> (i * 8));
+
+    return p + size;
+}
+
+static uint64_t bh_roaring_get(const unsigned char *p,
+                               size_t size)
+{
+    uint64_t result;
+    size_t i;
+
+    for (i = 0, result = 0; i < size; i++)
+        result |= (uint64_t)p[i] << (i * 8);
+
+    return result;
+}
+
+size_t bh_roaring_serialized_size(const bh_roaring_t *roaring)
+{
+    size_t i, result;
+
+    result = 4;
+    for (i = 0; i < bh_array_size(&roaring->chunks); i++)
+        result += 8 + bh_roaring_payload(BH_ROARING_CHUNK(roaring, i));
+
+    return result;
+}
+
+size_t bh_roaring_serialize(const bh_roaring_t *roaring,
+                            void *buffer)
+{
+    const bh_roaring_chunk_t *chunk;
+    const uint16_t *data;
+    const uint64_t *words;
+    unsigned char *p;
+    size_t i, j;
+
+    p = (unsigned char *)buffer;
+    p = bh_roaring_put(p, bh_array_size(&roaring->chunks), 4);
+
+    for (i = 0; i < bh_array_size(&roaring->chunks); i++)
+    {
+        chunk = BH_ROARING_CHUNK(roaring, i);
+        p = bh_roaring_put(p, chunk->key, 2);
+        p = bh_roaring_put(p, chunk->type, 2);
+        p = bh_roaring_put(p, (chunk->type == BH_ROARING_RUN) ? (chunk->runs) : (chunk->size), 4);
+
+        if (chunk->type == BH_ROARING_BITMAP)
+        {
+            words = (const uint64_t *)chunk->data;
+            for (j = 0; j < BH_ROARING_WORDS; j++)
+                p = bh_roaring_put(p, words[j], 8);
+        }
+        else
+        {
+            data = (const uint16_t *)chunk->data;
+            for (j = 0; j < bh_roaring_payload(chunk) / sizeof(uint16_t); j++)
+                p = bh_roaring_put(p, data[j], 2);
+        }
+    }
+
+    return (size_t)(p - (unsigned char *)buffer);
+}
+
+static int bh_roaring_read(const bh_allocator_t *allocator,
+                           bh_roaring_chunk_t *chunk,
+                           const unsigned char *p,
+                           size_t count)
+{
+    uint16_t *data;
+    uint64_t *words;
+    size_t i;
+
+    /* Containers should be in canonical form */
+    switch (chunk->type)
+    {
+    case BH_ROARING_BITMAP:
+        if (count <= BH_ROARING_ARRAY_MAX || count > BH_ROARING_BITS)
+            return -1;
+        if (bh_roaring_chunk_alloc(allocator, chunk, BH_ROARING_BITMAP, 0))
+            return -1;
+
+        words = (uint64_t *)chunk->data;
+        for (i = 0; i < BH_ROARING_WORDS; i++)
+            words[i] = bh_roaring_get(p + i * 8, 8);
+
+        chunk->size = count;
+        return (bh_roaring_popcount(words) == count) ? (0) : (-1);
+
+    case BH_ROARING_RUN:
+        if (!count || count > BH_ROARING_BITS / 2)
+            return -1;
+        if (bh_roaring_chunk_alloc(allocator, chunk, BH_ROARING_RUN, count * 2))
+            return -1;
+
+        data = (uint16_t *)chunk->data;
+        chunk->runs = count;
+        for (i = 0; i < count; i++)
+        {
+            data[2 * i] = (uint16_t)bh_roaring_get(p + i * 4, 2);
+            data[2 * i + 1] = (uint16_t)bh_roaring_get(p + i * 4 + 2, 2);
+            if (data[2 * i] > data[2 * i + 1] || (i && data[2 * i] <= data[2 * i - 1]))
+                return -1;
+            chunk->size += (size_t)data[2 * i + 1] - data[2 * i] + 1;
+        }
+        return 0;
+
+    case BH_ROARING_ARRAY:
+        if (!count || count > BH_ROARING_ARRAY_MAX)
+            return -1;
+        if (bh_roaring_chunk_alloc(allocator, chunk, BH_ROARING_ARRAY, count))
+            return -1;
+
+        data = (uint16_t *)chunk->data;
+        chunk->size = count;
+        for (i = 0; i < count; i++)
+        {
+            data[i] = (uint16_t)bh_roaring_get(p + i * 2, 2);
+            if (i && data[i] <= data[i - 1])
+                return -1;
+        }
+        return 0;
+    }
+
+    return -1;
+}
+
+int bh_roaring_deserialize(bh_roaring_t *roaring,
+                           const void *buffer,
+                           size_t size)
+{
+    const bh_allocator_t *allocator;
+    const unsigned char *p, *end;
+    bh_roaring_chunk_t *chunk;
+    bh_roaring_t result;
+    size_t i, count, chunks;
+
+    allocator = BH_ROARING_ALLOCATOR(roaring);
+    bh_roaring_init_alloc(&result, allocator);
+
+    p = (const unsigned char *)buffer;
+    end = p + size;
+    if (size < 4)
+        return -1;
+
+    chunks = (size_t)bh_roaring_get(p, 4);
+    p += 4;
+    if (chunks > (size_t)(end - p) / 8 || bh_array_reserve(&result.chunks, chunks))
+        return -1;
+
+    for (i = 0; i < chunks; i++)
+    {
+        if (end - p < 8)
+            goto fail;
+
+        chunk = (bh_roaring_chunk_t *)bh_array_insert(&result.chunks, i);
+        memset(chunk, 0, sizeof(*chunk));
+        chunk->key = (uint16_t)bh_roaring_get(p, 2);
+        chunk->type = (uint16_t)bh_roaring_get(p + 2, 2);
+        count = (size_t)bh_roaring_get(p + 4, 4);
+        p += 8;
+
+        /* Check chunk order and payload size before reading */
+        if (i && chunk->key <= BH_ROARING_CHUNK(&result, i - 1)->key)
+            goto fail_chunk;
+
+        chunk->size = count;
+        chunk->runs = count;
+        if (count > BH_ROARING_BITS || bh_roaring_payload(chunk) > (size_t)(end - p))
+            goto fail_chunk;
+
+        chunk->size = chunk->runs = 0;
+        if (bh_roaring_read(allocator, chunk, p, count))
+        {
+            if (chunk->data)
+                bh_roaring_chunk_free(allocator, chunk);
+            goto fail_chunk;
+        }
+
+        p += bh_roaring_payload(chunk);
+    }
+
+    bh_roaring_replace(roaring, &result);
+    return 0;
+
+fail_chunk:
+    bh_array_resize(&result.chunks, i);
+
+fail:
+    bh_roaring_destroy(&result);
+    return -1;
+}
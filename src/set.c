@@ -0,0 +1,513 @@
+/*
+ * BHLib
+ *
+ * Copyright (c) 2024 Mikhail Romanko
+ */
+#include <bh/algo.h>
+#include <string.h>
+#include <stdint.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BH_SET_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(BH_SET_SSE2) && defined(__AVX2__)
+#define BH_SET_AVX2
+#define BH_SET_AVX2_TARGET
+#include <immintrin.h>
+#elif defined(BH_SET_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BH_SET_AVX2
+#define BH_SET_AVX2_DISPATCH
+#define BH_SET_AVX2_TARGET __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+
+#define BH_SET_GALLOP_RATIO     16
+#define BH_SET_TYPED_RATIO      32
+
+static size_t bh_set_gallop(const void *key,
+                            const char *base,
+                            size_t size,
+                            size_t element,
+                            bh_compare_cb_t compare)
+{
+    size_t low, high, step;
+    char *found;
+
+    /* Exponential search to find search window */
+    low = 0;
+    step = 1;
+    while (step <= size && compare(base + (step - 1) * element, key) < 0)
+    {
+        low = step;
+        step <<= 1;
+    }
+    high = (step <= size) ? (step - 1) : (size);
+
+    /* Binary search within the window */
+    found = bh_lower_bound(key, (void *)(base + low * element), element, high - low, compare);
+    return (found - base) / element;
+}
+
+static int bh_set_skewed(size_t asize,
+                         size_t bsize)
+{
+    return asize / BH_SET_GALLOP_RATIO > bsize || bsize / BH_SET_GALLOP_RATIO > asize;
+}
+
+size_t bh_set_intersect(const void *a,
+                        size_t asize,
+                        const void *b,
+                        size_t bsize,
+                        void *out,
+                        size_t element,
+                        bh_compare_cb_t compare)
+{
+    const char *left, *right, *small, *large;
+    size_t i, j, count, ssize, lsize;
+    char *to;
+    int result;
+
+    left = (const char *)a;
+    right = (const char *)b;
+    to = (char *)out;
+    count = 0;
+
+    if (bh_set_skewed(asize, bsize))
+    {
+        /* Search elements of the smaller array in the larger one */
+        small = (asize < bsize) ? (left) : (right);
+        large = (asize < bsize) ? (right) : (left);
+        ssize = (asize < bsize) ? (asize) : (bsize);
+        lsize = (asize < bsize) ? (bsize) : (asize);
+
+        for (i = 0, j = 0; i < ssize && j < lsize; i++)
+        {
+            j += bh_set_gallop(small + i * element, large + j * element, lsize - j, element, compare);
+            if (j < lsize && !compare(small + i * element, large + j * element))
+            {
+                memcpy(to + count * element, (small == left) ? (small + i * element) : (large + j * element), element);
+                count++;
+                j++;
+            }
+        }
+
+        return count;
+    }
+
+    /* Linear merge */
+    i = 0;
+    j = 0;
+    while (i < asize && j < bsize)
+    {
+        result = compare(left + i * element, right + j * element);
+        if (result < 0)
+            i++;
+        else if (result > 0)
+            j++;
+        else
+        {
+            memcpy(to + count * element, left + i * element, element);
+            count++;
+            i++;
+            j++;
+        }
+    }
+
+    return count;
+}
+
+size_t bh_set_union(const void *a,
+                    size_t asize,
+                    const void *b,
+                    size_t bsize,
+                    void *out,
+                    size_t element,
+                    bh_compare_cb_t compare)
+{
+    const char *left, *right, *small, *large;
+    size_t i, j, k, count, ssize, lsize;
+    char *to;
+    int result;
+
+    left = (const char *)a;
+    right = (const char *)b;
+    to = (char *)out;
+    count = 0;
+
+    if (bh_set_skewed(asize, bsize))
+    {
+        /* Copy blocks of the larger array between elements of the smaller */
+        small = (asize < bsize) ? (left) : (right);
+        large = (asize < bsize) ? (right) : (left);
+        ssize = (asize < bsize) ? (asize) : (bsize);
+        lsize = (asize < bsize) ? (bsize) : (asize);
+
+        for (i = 0, j = 0; i < ssize; i++)
+        {
+            k = j + bh_set_gallop(small + i * element, large + j * element, lsize - j, element, compare);
+            memcpy(to + count * element, large + j * element, (k - j) * element);
+            count += k - j;
+            j = k;
+
+            if (j < lsize && !compare(small + i * element, large + j * element))
+            {
+                memcpy(to + count * element, (small == left) ? (small + i * element) : (large + j * element), element);
+                j++;
+            }
+            else
+                memcpy(to + count * element, small + i * element, element);
+            count++;
+        }
+
+        memcpy(to + count * element, large + j * element, (lsize - j) * element);
+        return count + lsize - j;
+    }
+
+    /* Linear merge */
+    i = 0;
+    j = 0;
+    while (i < asize && j < bsize)
+    {
+        result = compare(left + i * element, right + j * element);
+        if (result > 0)
+            memcpy(to + count * element, right + j++ * element, element);
+        else
+        {
+            memcpy(to + count * element, left + i++ * element, element);
+            j += !result;
+        }
+        count++;
+    }
+
+    /* Copy the rest */
+    memcpy(to + count * element, left + i * element, (asize - i) * element);
+    count += asize - i;
+    memcpy(to + count * element, right + j * element, (bsize - j) * element);
+    return count + bsize - j;
+}
+
+size_t bh_set_difference(const void *a,
+                         size_t asize,
+                         const void *b,
+                         size_t bsize,
+                         void *out,
+                         size_t element,
+                         bh_compare_cb_t compare)
+{
+    const char *left, *right;
+    size_t i, j, k, count;
+    char *to;
+    int result;
+
+    left = (const char *)a;
+    right = (const char *)b;
+    to = (char *)out;
+    count = 0;
+
+    if (bh_set_skewed(asize, bsize) && asize < bsize)
+    {
+        /* Search elements of the first array in the second one */
+        for (i = 0, j = 0; i < asize; i++)
+        {
+            j += bh_set_gallop(left + i * element, right + j * element, bsize - j, element, compare);
+            if (j < bsize && !compare(left + i * element, right + j * element))
+                j++;
+            else
+                memcpy(to + count++ * element, left + i * element, element);
+        }
+
+        return count;
+    }
+    else if (bh_set_skewed(asize, bsize))
+    {
+        /* Copy blocks of the first array between elements of the second */
+        for (i = 0, j = 0; j < bsize && i < asize; j++)
+        {
+            k = i + bh_set_gallop(right + j * element, left + i * element, asize - i, element, compare);
+            memcpy(to + count * element, left + i * element, (k - i) * element);
+            count += k - i;
+            i = k;
+
+            if (i < asize && !compare(right + j * element, left + i * element))
+                i++;
+        }
+
+        memcpy(to + count * element, left + i * element, (asize - i) * element);
+        return count + asize - i;
+    }
+
+    /* Linear merge */
+    i = 0;
+    j = 0;
+    while (i < asize && j < bsize)
+    {
+        result = compare(left + i * element, right + j * element);
+        if (result < 0)
+            memcpy(to + count++ * element, left + i++ * element, element);
+        else
+        {
+            i += !result;
+            j++;
+        }
+    }
+
+    /* Copy the rest */
+    memcpy(to + count * element, left + i * element, (asize - i) * element);
+    return count + asize - i;
+}
+
+/* Scalar and galloping intersection for fixed size integer keys */
+#define BH_SET_TYPED_DEFINE(name, type)                                         \
+static const type *name##_gallop(type key,                                      \
+                                 const type *base,                              \
+                                 const type *end)                               \
+{                                                                               \
+    const type *low;                                                            \
+    size_t size, step, half;                                                    \
+                                                                                \
+    /* Exponential search to find search window */                             \
+    size = end - base;                                                          \
+    low = base;                                                                 \
+    step = 1;                                                                   \
+    while (step <= size && base[step - 1] < key)                                \
+    {                                                                           \
+        low = base + step;                                                      \
+        step <<= 1;                                                             \
+    }                                                                           \
+    size = ((step <= size) ? (step - 1) : (size)) - (low - base);               \
+    if (!size)                                                                  \
+        return low;                                                             \
+                                                                                \
+    /* Branchless binary search within the window */                           \
+    while (size > 1)                                                            \
+    {                                                                           \
+        half = size / 2;                                                        \
+        low = (low[half] < key) ? (low + half) : (low);                         \
+        size -= half;                                                           \
+    }                                                                           \
+    return low + (low[0] < key);                                                \
+}                                                                               \
+                                                                                \
+static size_t name##_skewed(const type *small,                                  \
+                            size_t size,                                        \
+                            const type *large,                                  \
+                            const type *end,                                    \
+                            type *out)                                          \
+{                                                                               \
+    size_t i, count;                                                            \
+                                                                                \
+    for (i = 0, count = 0; i < size && large < end; i++)                        \
+    {                                                                           \
+        large = name##_gallop(small[i], large, end);                            \
+        if (large < end && *large == small[i])                                  \
+        {                                                                       \
+            out[count++] = small[i];                                            \
+            large++;                                                            \
+        }                                                                       \
+    }                                                                           \
+    return count;                                                               \
+}                                                                               \
+                                                                                \
+static size_t name##_scalar(const type *a,                                      \
+                            const type *aend,                                   \
+                            const type *b,                                      \
+                            const type *bend,                                   \
+                            type *out)                                          \
+{                                                                               \
+    size_t count;                                                               \
+    type x, y;                                                                  \
+                                                                                \
+    /* Branchless merge: output is written unconditionally */                  \
+    count = 0;                                                                  \
+    while (a < aend && b < bend)                                                \
+    {                                                                           \
+        x = *a;                                                                 \
+        y = *b;                                                                 \
+        out[count] = x;                                                         \
+        count += (x == y);                                                      \
+        a += (x <= y);                                                          \
+        b += (y <= x);                                                          \
+    }                                                                           \
+    return count;                                                               \
+}
+
+BH_SET_TYPED_DEFINE(bh_set32, uint32_t)
+BH_SET_TYPED_DEFINE(bh_set64, uint64_t)
+
+#if defined(BH_SET_SSE2)
+static size_t bh_set32_block_sse2(const uint32_t **a,
+                                  const uint32_t *aend,
+                                  const uint32_t **b,
+                                  const uint32_t *bend,
+                                  uint32_t *out)
+{
+    const uint32_t *left, *right;
+    uint32_t amax, bmax;
+    __m128i va, vb, mask;
+    size_t count, i;
+    int bits;
+
+    left = *a;
+    right = *b;
+    count = 0;
+
+    /* Compare blocks of 4 elements against all rotations of each other */
+    while (left + 4 <= aend && right + 4 <= bend)
+    {
+        va = _mm_loadu_si128((const __m128i *)left);
+        vb = _mm_loadu_si128((const __m128i *)right);
+        mask = _mm_cmpeq_epi32(va, vb);
+        vb = _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1));
+        mask = _mm_or_si128(mask, _mm_cmpeq_epi32(va, vb));
+        vb = _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1));
+        mask = _mm_or_si128(mask, _mm_cmpeq_epi32(va, vb));
+        vb = _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1));
+        mask = _mm_or_si128(mask, _mm_cmpeq_epi32(va, vb));
+        bits = _mm_movemask_ps(_mm_castsi128_ps(mask));
+
+        /* Write matched lanes only, output can be full */
+        for (i = 0; bits; i++, bits >>= 1)
+            if (bits & 1)
+                out[count++] = left[i];
+
+        /* Advance block with the smaller maximum (or both) */
+        amax = left[3];
+        bmax = right[3];
+        left += (amax <= bmax) * 4;
+        right += (bmax <= amax) * 4;
+    }
+
+    *a = left;
+    *b = right;
+    return count;
+}
+#endif
+
+#if defined(BH_SET_AVX2)
+static BH_SET_AVX2_TARGET size_t bh_set64_block_avx2(const uint64_t **a,
+                                                     const uint64_t *aend,
+                                                     const uint64_t **b,
+                                                     const uint64_t *bend,
+                                                     uint64_t *out)
+{
+    const uint64_t *left, *right;
+    uint64_t amax, bmax;
+    __m256i va, vb, mask;
+    size_t count, i;
+    int bits;
+
+    left = *a;
+    right = *b;
+    count = 0;
+
+    /* Compare blocks of 4 elements against all rotations of each other */
+    while (left + 4 <= aend && right + 4 <= bend)
+    {
+        va = _mm256_loadu_si256((const __m256i *)left);
+        vb = _mm256_loadu_si256((const __m256i *)right);
+        mask = _mm256_cmpeq_epi64(va, vb);
+        vb = _mm256_permute4x64_epi64(vb, _MM_SHUFFLE(0, 3, 2, 1));
+        mask = _mm256_or_si256(mask, _mm256_cmpeq_epi64(va, vb));
+        vb = _mm256_permute4x64_epi64(vb, _MM_SHUFFLE(0, 3, 2, 1));
+        mask = _mm256_or_si256(mask, _mm256_cmpeq_epi64(va, vb));
+        vb = _mm256_permute4x64_epi64(vb, _MM_SHUFFLE(0, 3, 2, 1));
+        mask = _mm256_or_si256(mask, _mm256_cmpeq_epi64(va, vb));
+        bits = _mm256_movemask_pd(_mm256_castsi256_pd(mask));
+
+        /* Write matched lanes only, output can be full */
+        for (i = 0; bits; i++, bits >>= 1)
+            if (bits & 1)
+                out[count++] = left[i];
+
+        /* Advance block with the smaller maximum (or both) */
+        amax = left[3];
+        bmax = right[3];
+        left += (amax <= bmax) * 4;
+        right += (bmax <= amax) * 4;
+    }
+
+    *a = left;
+    *b = right;
+    return count;
+}
+
+static int bh_set_avx2(void)
+{
+#if defined(BH_SET_AVX2_DISPATCH)
+    static int avx2 = -1;
+
+    /* Check CPU features once, races are harmless (same value is stored) */
+    if (avx2 < 0)
+    {
+        __builtin_cpu_init();
+        avx2 = __builtin_cpu_supports("avx2") != 0;
+    }
+    return avx2;
+#else
+    return 1;
+#endif
+}
+#endif
+
+size_t bh_set_intersect32(const void *a,
+                          size_t asize,
+                          const void *b,
+                          size_t bsize,
+                          void *out)
+{
+    const uint32_t *left, *right, *lend, *rend;
+    uint32_t *to;
+    size_t count;
+
+    left = (const uint32_t *)a;
+    right = (const uint32_t *)b;
+    lend = left + asize;
+    rend = right + bsize;
+    to = (uint32_t *)out;
+    count = 0;
+
+    /* Gallop over the larger array if sizes differ a lot */
+    if (asize / BH_SET_TYPED_RATIO > bsize)
+        return bh_set32_skewed(right, bsize, left, lend, to);
+    if (bsize / BH_SET_TYPED_RATIO > asize)
+        return bh_set32_skewed(left, asize, right, rend, to);
+
+#if defined(BH_SET_SSE2)
+    count = bh_set32_block_sse2(&left, lend, &right, rend, to);
+#endif
+
+    return count + bh_set32_scalar(left, lend, right, rend, to + count);
+}
+
+size_t bh_set_intersect64(const void *a,
+                          size_t asize,
+                          const void *b,
+                          size_t bsize,
+                          void *out)
+{
+    const uint64_t *left, *right, *lend, *rend;
+    uint64_t *to;
+    size_t count;
+
+    left = (const uint64_t *)a;
+    right = (const uint64_t *)b;
+    lend = left + asize;
+    rend = right + bsize;
+    to = (uint64_t *)out;
+    count = 0;
+
+    /* Gallop over the larger array if sizes differ a lot */
+    if (asize / BH_SET_TYPED_RATIO > bsize)
+        return bh_set64_skewed(right, bsize, left, lend, to);
+    if (bsize / BH_SET_TYPED_RATIO > asize)
+        return bh_set64_skewed(left, asize, right, rend, to);
+
+#if defined(BH_SET_AVX2)
+    if (bh_set_avx2())
+        count = bh_set64_block_avx2(&left, lend, &right, rend, to);
+#endif
+
+    return count + bh_set64_scalar(left, lend, right, rend, to + count);
+}
@@ -107,3 +107,12 @@ void bh_cond_destroy(bh_cond_t *cond)
 {
     (void)cond;
 }
+
+int bh_tpool_init(bh_tpool_t *pool,
+                  size_t size)
+{
+    (void)pool;
+    (void)size;
+
+    return -1;
+}
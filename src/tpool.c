@@ -1,24 +1,101 @@
 #include <bh/thread.h>
 
+void bh_tpool_worker(void *data)
+{
+    bh_tpool_t *pool;
+    bh_tpool_job_t job;
+
+    pool = (bh_tpool_t *)data;
+    bh_mutex_lock(&pool->mutex);
+    while (1)
+    {
+        /* Wait for the job or shutdown request */
+        while (!pool->shutdown && !bh_queue_size(&pool->jobs))
+            bh_cond_wait(&pool->condition, &pool->mutex);
+
+        /* Pending jobs are finished before shutdown */
+        if (!bh_queue_size(&pool->jobs))
+            break;
+
+        job = *(bh_tpool_job_t *)bh_queue_front(&pool->jobs);
+        bh_queue_pop_front(&pool->jobs);
+        pool->active++;
+
+        /* Run job without holding the lock */
+        bh_mutex_unlock(&pool->mutex);
+        job.func(job.data);
+        bh_mutex_lock(&pool->mutex);
+
+        /* Notify joining threads when all jobs are done */
+        pool->active--;
+        if (!pool->active && !bh_queue_size(&pool->jobs))
+            bh_cond_broadcast(&pool->done);
+    }
+    bh_mutex_unlock(&pool->mutex);
+}
+
 int bh_tpool_job(bh_tpool_t *pool,
-                 bh_thread_cb_t job,
+                 bh_thread_cb_t func,
                  void *data)
 {
-    (void)pool;
-    (void)job;
-    (void)data;
+    bh_tpool_job_t *job;
 
-    return -1;
+    /* Pool without threads can't run any jobs */
+    if (!bh_array_size(&pool->threads))
+        return -1;
+
+    if (bh_mutex_lock(&pool->mutex))
+        return -1;
+
+    job = bh_queue_push_back(&pool->jobs);
+    if (!job)
+    {
+        bh_mutex_unlock(&pool->mutex);
+        return -1;
+    }
+
+    job->func = func;
+    job->data = data;
+    bh_cond_signal(&pool->condition);
+    bh_mutex_unlock(&pool->mutex);
+
+    return 0;
 }
 
 int bh_tpool_join(bh_tpool_t *pool)
 {
-    (void)pool;
+    if (bh_mutex_lock(&pool->mutex))
+        return -1;
 
-    return -1;
+    /* Wait until queue is empty and no job is running */
+    while (pool->active || bh_queue_size(&pool->jobs))
+    {
+        if (bh_cond_wait(&pool->done, &pool->mutex))
+        {
+            bh_mutex_unlock(&pool->mutex);
+            return -1;
+        }
+    }
+
+    return bh_mutex_unlock(&pool->mutex);
 }
 
 void bh_tpool_destroy(bh_tpool_t *pool)
 {
-    (void)pool;
+    size_t i;
+
+    /* Request shutdown and wake up all threads */
+    bh_mutex_lock(&pool->mutex);
+    pool->shutdown = 1;
+    bh_cond_broadcast(&pool->condition);
+    bh_mutex_unlock(&pool->mutex);
+
+    for (i = 0; i < bh_array_size(&pool->threads); i++)
+        bh_thread_join(bh_array_at(&pool->threads, i));
+
+    bh_cond_destroy(&pool->done);
+    bh_cond_destroy(&pool->condition);
+    bh_mutex_destroy(&pool->mutex);
+    bh_queue_destroy(&pool->jobs);
+    bh_array_destroy(&pool->threads);
 }
@@ -0,0 +1,134 @@
+/*
+ * BHLib
+ *
+ * Copyright (c) 2024 Mikhail Romanko
+ */
+#include <bh/ds.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BH_TEST_CHECK(expr)                                                     \
+    do                                                                          \
+    {                                                                           \
+        if (!(expr))                                                            \
+        {                                                                       \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #expr);     \
+            return -1;                                                          \
+        }                                                                       \
+    } while (0)
+
+static int compare(const void *a,
+                   const void *b)
+{
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+/* Pushing no elements should not touch the queue */
+static int test_push_empty(void)
+{
+    bh_pqueue_t queue;
+    int items[1] = {0};
+
+    bh_pqueue_init(&queue, sizeof(int), 0, compare);
+    BH_TEST_CHECK(bh_pqueue_push_n(&queue, items, 0) == 0);
+    BH_TEST_CHECK(bh_pqueue_size(&queue) == 0);
+    BH_TEST_CHECK(bh_pqueue_top(&queue) == NULL);
+    bh_pqueue_destroy(&queue);
+    return 0;
+}
+
+/* Size overflow should be rejected before touching the buffer */
+static int test_push_overflow(void)
+{
+    bh_pqueue_t queue;
+    int items[2] = {1, 2};
+
+    bh_pqueue_init(&queue, sizeof(int), 0, compare);
+    bh_pqueue_set_growth(&queue, 150);
+    BH_TEST_CHECK(bh_pqueue_push_n(&queue, items, 2) == 0);
+    BH_TEST_CHECK(bh_pqueue_push_n(&queue, items, (size_t)-1) != 0);
+    BH_TEST_CHECK(bh_pqueue_size(&queue) == 2);
+    BH_TEST_CHECK(*(int *)bh_pqueue_top(&queue) == 2);
+    bh_pqueue_destroy(&queue);
+    return 0;
+}
+
+/* Pushing elements of the queue itself should survive reallocation */
+static int test_push_alias(void)
+{
+    bh_pqueue_t queue;
+    size_t capacity, grown;
+    int item;
+
+    bh_pqueue_init(&queue, sizeof(int), 0, compare);
+    item = 7;
+    BH_TEST_CHECK(bh_pqueue_push(&queue, &item) == 0);
+
+    /* Push top element until the queue grows a few times */
+    for (grown = 0; grown < 4;)
+    {
+        capacity = bh_pqueue_capacity(&queue);
+        BH_TEST_CHECK(bh_pqueue_push(&queue, bh_pqueue_top(&queue)) == 0);
+        if (bh_pqueue_capacity(&queue) != capacity)
+            grown++;
+    }
+
+    /* Push whole content of the queue */
+    capacity = bh_pqueue_size(&queue);
+    BH_TEST_CHECK(bh_pqueue_push_n(&queue, bh_pqueue_top(&queue), capacity) == 0);
+    BH_TEST_CHECK(bh_pqueue_size(&queue) == capacity * 2);
+
+    for (; bh_pqueue_size(&queue); bh_pqueue_pop(&queue))
+        BH_TEST_CHECK(*(int *)bh_pqueue_top(&queue) == 7);
+
+    bh_pqueue_destroy(&queue);
+    return 0;
+}
+
+/* Elements should be popped in descending order */
+static int test_push_n(void)
+{
+    bh_pqueue_t queue;
+    int items[1000], last, i, round;
+    size_t count;
+
+    srand(42);
+    for (round = 0; round < 100; round++)
+    {
+        bh_pqueue_init(&queue, sizeof(int), 2 + round % 4, compare);
+        for (count = 0; count < 1000;)
+        {
+            i = rand() % 64;
+            if (i > (int)(1000 - count))
+                i = (int)(1000 - count);
+            for (last = 0; last < i; last++)
+                items[last] = rand() % 100;
+            BH_TEST_CHECK(bh_pqueue_push_n(&queue, items, i) == 0);
+            count += i;
+        }
+
+        BH_TEST_CHECK(bh_pqueue_size(&queue) == 1000);
+        for (last = 100; bh_pqueue_size(&queue); bh_pqueue_pop(&queue))
+        {
+            BH_TEST_CHECK(*(int *)bh_pqueue_top(&queue) <= last);
+            last = *(int *)bh_pqueue_top(&queue);
+        }
+        bh_pqueue_destroy(&queue);
+    }
+
+    return 0;
+}
+
+int main(void)
+{
+    int result;
+
+    result = 0;
+    result |= test_push_empty();
+    result |= test_push_overflow();
+    result |= test_push_alias();
+    result |= test_push_n();
+
+    return (result) ? (EXIT_FAILURE) : (EXIT_SUCCESS);
+}
@@ -0,0 +1,121 @@
+/*
+ * BHLib
+ *
+ * Copyright (c) 2024 Mikhail Romanko
+ */
+#include <bh/algo.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#define BH_TEST_CANARY 0xDEADBEEFu
+
+#define BH_TEST_CHECK(expr)                                                     \
+    do                                                                          \
+    {                                                                           \
+        if (!(expr))                                                            \
+        {                                                                       \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #expr);     \
+            return -1;                                                          \
+        }                                                                       \
+    } while (0)
+
+static int compare32(const void *a,
+                     const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static int compare64(const void *a,
+                     const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* Output of min(asize, bsize) elements should be enough */
+static int test_full_output(void)
+{
+    uint32_t a32[8] = {1, 2, 3, 4, 5, 6, 7, 8}, b32[4] = {2, 3, 4, 5};
+    uint64_t a64[8] = {1, 2, 3, 4, 5, 6, 7, 8}, b64[4] = {2, 3, 4, 5};
+    uint32_t *out32;
+    uint64_t *out64;
+    size_t i;
+
+    out32 = malloc(5 * sizeof(*out32));
+    out64 = malloc(5 * sizeof(*out64));
+    BH_TEST_CHECK(out32 && out64);
+
+    out32[4] = BH_TEST_CANARY;
+    out64[4] = BH_TEST_CANARY;
+    BH_TEST_CHECK(bh_set_intersect32(a32, 8, b32, 4, out32) == 4);
+    BH_TEST_CHECK(bh_set_intersect64(a64, 8, b64, 4, out64) == 4);
+    BH_TEST_CHECK(out32[4] == BH_TEST_CANARY);
+    BH_TEST_CHECK(out64[4] == BH_TEST_CANARY);
+
+    for (i = 0; i < 4; i++)
+    {
+        BH_TEST_CHECK(out32[i] == b32[i]);
+        BH_TEST_CHECK(out64[i] == b64[i]);
+    }
+
+    free(out32);
+    free(out64);
+    return 0;
+}
+
+/* Typed intersections should match generic one */
+static int test_random(void)
+{
+    uint32_t a32[256], b32[256], out32[257], ref32[256];
+    uint64_t a64[256], b64[256], out64[257], ref64[256];
+    size_t asize, bsize, size, expected, i, round;
+    uint32_t value;
+
+    srand(42);
+    for (round = 0; round < 1000; round++)
+    {
+        asize = rand() % 256;
+        bsize = rand() % 256;
+
+        /* Strictly increasing arrays */
+        for (i = 0, value = 0; i < asize; i++)
+            a32[i] = value += 1 + rand() % 4;
+        for (i = 0, value = 0; i < bsize; i++)
+            b32[i] = value += 1 + rand() % 4;
+        for (i = 0; i < asize; i++)
+            a64[i] = ((uint64_t)a32[i] << 32) | a32[i];
+        for (i = 0; i < bsize; i++)
+            b64[i] = ((uint64_t)b32[i] << 32) | b32[i];
+
+        size = (asize < bsize) ? (asize) : (bsize);
+        out32[size] = BH_TEST_CANARY;
+        out64[size] = BH_TEST_CANARY;
+
+        expected = bh_set_intersect(a32, asize, b32, bsize, ref32, sizeof(uint32_t), compare32);
+        BH_TEST_CHECK(bh_set_intersect32(a32, asize, b32, bsize, out32) == expected);
+        BH_TEST_CHECK(out32[size] == BH_TEST_CANARY);
+        for (i = 0; i < expected; i++)
+            BH_TEST_CHECK(out32[i] == ref32[i]);
+
+        expected = bh_set_intersect(a64, asize, b64, bsize, ref64, sizeof(uint64_t), compare64);
+        BH_TEST_CHECK(bh_set_intersect64(a64, asize, b64, bsize, out64) == expected);
+        BH_TEST_CHECK(out64[size] == BH_TEST_CANARY);
+        for (i = 0; i < expected; i++)
+            BH_TEST_CHECK(out64[i] == ref64[i]);
+    }
+
+    return 0;
+}
+
+int main(void)
+{
+    int result;
+
+    result = 0;
+    result |= test_full_output();
+    result |= test_random();
+
+    return (result) ? (EXIT_FAILURE) : (EXIT_SUCCESS);
+}